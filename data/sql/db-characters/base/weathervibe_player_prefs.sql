@@ -0,0 +1,7 @@
+-- WeatherVibe personal weather settings (.wvibe me), one row per character with non-default settings
+CREATE TABLE IF NOT EXISTS `weathervibe_player_prefs` (
+  `guid` INT UNSIGNED NOT NULL COMMENT 'character guid (low part)',
+  `max_pct` TINYINT UNSIGNED NOT NULL DEFAULT 100 COMMENT 'intensity cap, percent of the full grade',
+  `blocked` SMALLINT UNSIGNED NOT NULL DEFAULT 0 COMMENT 'one bit per accepted weather state, shown as fine',
+  PRIMARY KEY (`guid`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE=utf8mb4_unicode_ci;
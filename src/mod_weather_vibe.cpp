@@ -2,14 +2,17 @@
 // 
 //  - Auto-rotation engine with profiles (weights, percent bands, windows, tweening)
 //  - Zone parent mapping (capitals/starter zones inherit parent zone climate)
-//  - Sprinkle: temporary override spikes (with duration)
+//  - Sprinkle: temporary override spikes (with duration), stacked by priority/tag
 //  - Richer .show and new .wvibe auto/* admin commands
+//  - Offline fast-forward simulation (.wvibe sim) for tuning profiles
 //  - 0% clear for FINE, baseline caps through config ranges
 //
 // Notes:
 //  * The auto engine is optional (WeatherVibe.Auto.Enable).
 //  * Profiles maps are configured via strings (see config comment block below).
 //  * We use direct Weather packets (no WeatherMgr/objects). Last-applied is kept.
+//  * .wvibe reload/show/auto status run their heavy part on a background task; results are applied
+//    and replied on the world thread (console: inline).
 //
 // ===================== CONFIG KEYS (add to .conf) =====================
 // Toggle module
@@ -23,6 +26,7 @@
 //   WeatherVibe.DayPart.AFTERNOON.Start = 12:00
 //   WeatherVibe.DayPart.EVENING.Start   = 18:00
 //   WeatherVibe.DayPart.NIGHT.Start     = 22:00
+//   WeatherVibe.DayPart.BlendMinutes    = 30   # ranges cross-fade over this window around each start (0 = instant)
 // Per-state InternalRange per daypart per weather effect.
 //
 // --- (Auto engine) ---
@@ -31,7 +35,12 @@
 //   WeatherVibe.Auto.MinWindowSec = 180    # min seconds a picked state should live before new pick
 //   WeatherVibe.Auto.MaxWindowSec = 480    # max seconds a picked state should live
 //   WeatherVibe.Auto.TweenSec = 20         # seconds to ramp toward target each change
+//   WeatherVibe.Auto.TweenCurve = linear   # linear|smoothstep|easeinout
 //   WeatherVibe.Auto.TinyNudge = 0.01      # raw delta under which we skip sending
+//   WeatherVibe.Auto.PacketBudget = 0      # packets/min per zone; >0 makes the nudge adaptive per zone
+//   WeatherVibe.Auto.NudgeMin = 0.002      # adaptive nudge bounds
+//   WeatherVibe.Auto.NudgeMax = 0.10
+//   WeatherVibe.Auto.RateWindowSec = 60    # send-rate EWMA time constant
 //
 // Profiles config:
 //   WeatherVibe.Profile.Names = Temperate,Tundra,Desert
@@ -45,15 +54,73 @@
 //   WeatherVibe.Profile.Desert.Percent.Min = 5
 //   WeatherVibe.Profile.Desert.Percent.Max = 55
 //
+// Optional seasonal / daypart layers per profile (absolute "40" or delta "+10"/"-5"; daypart applies
+// after season). Expanded at load into a [season][daypart] table of alias samplers + percent bands:
+//   WeatherVibe.Profile.Tundra.WINTER.Weights = 7=+10,8=+5
+//   WeatherVibe.Profile.Tundra.NIGHT.Percent.Max = +5
+//
+// Optional transition rows per profile (next-state weights after the current state; rows not given,
+// or picks the current cell gives no weight, use the cell weights):
+//   WeatherVibe.Profile.Tundra.Next.8 = 8=40,7=40,1=20
+//
 // Assign profiles to zones (controller zones only; children inherit via ZoneParent):
 //   WeatherVibe.ZoneProfile.Map = 1=Temperate,3=Temperate,8=Tundra,10=Desert
 //
+// Per-zone profile tweaks (absolute "40" or delta "+10"/"-5" over the zone's profile):
+//   WeatherVibe.ZoneOverride.Zones = 10
+//   WeatherVibe.ZoneOverride.10.Weights = 5=+10,86=+5,0=-15
+//   WeatherVibe.ZoneOverride.10.Percent.Max = +5
+//
+// Area controllers (sub-zones with their own auto weather; only players inside receive it):
+//   WeatherVibe.AreaProfile.Map = 42=Moderate
+//
+// Zone parents (child=parent; children receive their controller's weather):
+//   WeatherVibe.ZoneParent.Map = 1519=12,1537=1
+//
+// Regional spillover (optional): strong picks start a front that walks zone links with a per-hop
+// delay and percent decay; a neighbour only takes it if its profile allows that state:
+//   WeatherVibe.Spillover.Enable     = 0
+//   WeatherVibe.Spillover.Links      = 12-40,12-10,40-10   # undirected controller zone links
+//   WeatherVibe.Spillover.DelaySec   = 120
+//   WeatherVibe.Spillover.Decay      = 0.7
+//   WeatherVibe.Spillover.TriggerPct = 35
+//   WeatherVibe.Spillover.MinPct     = 15
+//   WeatherVibe.Spillover.MaxHops    = 3
+//
+// Regions (optional): one simulation per region picks the targets; member zones follow with a fixed
+// per-zone offset, per-pick noise and a staggered start, and pick locally only where the state has
+// no weight in their own profile:
+//   WeatherVibe.Region.Names = Northrend
+//   WeatherVibe.Region.Northrend.Profile = NorthrendFrozen
+//   WeatherVibe.Region.Northrend.Zones = 3537,495,65,394,66
+//   WeatherVibe.Region.SpreadPct  = 10
+//   WeatherVibe.Region.NoisePct   = 5
+//   WeatherVibe.Region.StaggerSec = 90
+//
+// Timelines (optional): scripted steps "<state>:<pct>:<sec>" applied over the auto pick in the
+// listed zones, daily at Start (local HH:MM) and/or via `.wvibe timeline start <name>`:
+//   WeatherVibe.Timeline.Names = Storm
+//   WeatherVibe.Timeline.Storm.Zones = 12,40,10
+//   WeatherVibe.Timeline.Storm.Start = 20:00
+//   WeatherVibe.Timeline.Storm.Steps = fog:40:600,thunders:80:300,fine:0:60
+//
+// Precompiled catalog (optional; built with `.wvibe pack build <file>`). When set and valid,
+// ranges/profiles/zone map/parents/links come from the pack and their config keys are ignored:
+//   WeatherVibe.Pack.File = /path/to/climate.wvpk
+//
+// Files written by commands (pack build, sim) land in this directory; command paths must be relative:
+//   WeatherVibe.OutputDir =
+//
 // =====================================================================
 
 #include "ScriptMgr.h"
 #include "Chat.h"
 #include "ChatCommand.h"
 #include "Config.h"
+#include "DatabaseEnv.h"
+#include "DBCStores.h"
+#include "Errors.h"
+#include "ObjectAccessor.h"
 #include "Player.h"
 #include "World.h"
 #include "WorldSession.h"
@@ -64,22 +131,33 @@
 
 #include <algorithm>
 #include <cctype>
-#include <cstdio>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
 #include <iomanip>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
 #include <memory>
 #include <ctime>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <future>
 #include <array>
+#include <deque>
 #include <vector>
 #include <random>
 
 using Acore::ChatCommands::ChatCommandTable;
 using Acore::ChatCommands::Console;
 
+class ConfigSnapshot;
+
 // ===============================
 // constants, enums, structs (top)
 // ===============================
@@ -88,6 +166,23 @@ namespace
     constexpr float kMinGrade = 0.0001f;
     constexpr float kMaxGrade = 0.9999f;
 
+    // Every state the module accepts, in dense index order (see StateIndex()).
+    constexpr std::array<WeatherState, 12> kAcceptedStates = {
+        WEATHER_STATE_FINE,
+        WEATHER_STATE_FOG,
+        WEATHER_STATE_LIGHT_RAIN,
+        WEATHER_STATE_MEDIUM_RAIN,
+        WEATHER_STATE_HEAVY_RAIN,
+        WEATHER_STATE_LIGHT_SNOW,
+        WEATHER_STATE_MEDIUM_SNOW,
+        WEATHER_STATE_HEAVY_SNOW,
+        WEATHER_STATE_LIGHT_SANDSTORM,
+        WEATHER_STATE_MEDIUM_SANDSTORM,
+        WEATHER_STATE_HEAVY_SANDSTORM,
+        WEATHER_STATE_THUNDERS
+    };
+    constexpr size_t kStateCount = kAcceptedStates.size();
+
     enum class DayPart : uint8
     {
         MORNING = 0,
@@ -97,6 +192,34 @@ namespace
         COUNT
     };
 
+    enum class TweenCurve : uint8
+    {
+        LINEAR = 0,
+        SMOOTHSTEP,
+        EASE_IN_OUT,
+        COUNT
+    };
+
+    // Easing curves sampled at kEaseSteps + 1 points over t in [0,1]; built at compile time.
+    constexpr size_t kEaseSteps = 256;
+    using EaseTable = std::array<std::array<float, kEaseSteps + 1>, (size_t)TweenCurve::COUNT>;
+
+    constexpr EaseTable BuildEaseTables()
+    {
+        EaseTable lut{};
+        for (size_t i = 0; i <= kEaseSteps; ++i)
+        {
+            float t = float(i) / float(kEaseSteps);
+            float u = 2.0f - 2.0f * t;
+            lut[(size_t)TweenCurve::LINEAR][i] = t;
+            lut[(size_t)TweenCurve::SMOOTHSTEP][i] = t * t * (3.0f - 2.0f * t);
+            lut[(size_t)TweenCurve::EASE_IN_OUT][i] = t < 0.5f ? 4.0f * t * t * t : 1.0f - u * u * u / 2.0f; // cubic
+        }
+        return lut;
+    }
+
+    constexpr EaseTable kEaseLut = BuildEaseTables();
+
     enum class Season : uint8
     {
         SPRING = 0,
@@ -116,35 +239,203 @@ namespace
         int night = 22 * 60;      // 22:00
     };
 
+    // Walker/Vose alias table over the dense state index: O(1) draw, no allocation.
+    struct StateSampler
+    {
+        std::array<float, kStateCount> prob{};  // keep-column threshold per column
+        std::array<uint8, kStateCount> alias{}; // fallback column
+        bool empty = true;                      // all weights zero -> FINE
+    };
+
+    // Last weather pushed to a controller, packed to 8 bytes (grade in 1/65535 steps, well under any nudge).
     struct LastApplied
     {
-        WeatherState state = WEATHER_STATE_FINE;
-        float grade = 0.f;
-        bool hasValue = false; // anti-spam
+        uint32 zone = 0;
+        uint8  state = WEATHER_STATE_FINE;
+        uint8  pad = 0;
+        uint16 grade = 0;
+
+        WeatherState State() const { return WeatherState(state); }
+        float Grade() const { return grade / 65535.0f; }
+    };
+    static_assert(sizeof(LastApplied) == 8, "LastApplied is a packed 8-byte record");
+
+    // Snapshots in a dense record vector plus a slot index by zone/area id (0 = none). Only ids the
+    // AreaTable knows are stored, so both stay bounded by the DBC however many ids commands throw at it.
+    class LastAppliedStore
+    {
+    public:
+        LastApplied const* Find(uint32 zone) const
+        {
+            return zone < _slot.size() && _slot[zone] ? &_records[_slot[zone] - 1] : nullptr;
+        }
+
+        bool Set(uint32 zone, WeatherState state, float grade)
+        {
+            if (!sAreaTableStore.LookupEntry(zone) || uint32(state) > 0xFF)
+                return false;
+            if (zone >= _slot.size())
+                _slot.resize(zone + 1, 0);
+            if (!_slot[zone])
+            {
+                _records.push_back(LastApplied{ zone });
+                _slot[zone] = uint16(_records.size());
+            }
+            LastApplied& rec = _records[_slot[zone] - 1];
+            rec.state = uint8(state);
+            rec.grade = uint16(std::lround(std::clamp(grade, 0.0f, 1.0f) * 65535.0f));
+            return true;
+        }
+
+        void Clear() { _records.clear(); _slot.clear(); }
+        bool Empty() const { return _records.empty(); }
+        size_t Size() const { return _records.size(); }
+        std::vector<LastApplied> const& Records() const { return _records; }
+        size_t RecordBytes() const { return _records.capacity() * sizeof(LastApplied); }
+        size_t IndexBytes() const { return _slot.capacity() * sizeof(uint16); }
+
+    private:
+        std::vector<LastApplied> _records;
+        std::vector<uint16> _slot; // zone/area id -> record index + 1
+    };
+
+    // ================= Player personalization =================
+    // Per-player opt-outs applied at send time. Key() is exact (no collisions), so players with equal
+    // settings are grouped by it and share one serialized packet.
+    struct PlayerPrefs
+    {
+        uint8  maxPct = 100;    // client intensity cap, percent of the full grade
+        uint16 blocked = 0;     // bit per dense state index; blocked states are shown as fine
+
+        bool IsDefault() const { return maxPct >= 100 && blocked == 0; }
+        uint32 Key() const { return (uint32(blocked) << 8) | maxPct; }
     };
+    static_assert(kStateCount <= 16, "PlayerPrefs::blocked holds one bit per state");
 
     // ================= Auto engine =================
-    struct Profile
+    // One compiled (season, daypart) slice of a profile: everything ChooseNewTarget reads.
+    struct ProfileCell
     {
-        std::string name;
-        // weights per state id (0..). Absent or zero weight means not used.
-        std::unordered_map<uint32, uint32> weights;
+        // weights per dense state index (see StateIndex()). Zero weight means not used.
+        std::array<uint32, kStateCount> weights{};
+        StateSampler sampler;  // compiled from weights
         float pctMin = 5.0f; // percent 0..100
         float pctMax = 55.0f;
     };
 
+    constexpr size_t kProfileCells = (size_t)Season::COUNT * (size_t)DayPart::COUNT;
+
+    // Optional Markov rows of a profile: next-state weights given the current state, one alias table
+    // per row (by dense state index). Unconfigured rows stay empty and use the cell weights.
+    struct TransitionTable
+    {
+        std::array<std::array<uint32, kStateCount>, kStateCount> weights{}; // [from][to], all zero = no row
+        std::array<StateSampler, kStateCount> rows; // compiled from weights
+    };
+
+    struct Profile
+    {
+        std::string name;
+        // base + season layer + daypart layer, expanded at load; index with CellIndex()
+        std::array<ProfileCell, kProfileCells> cells;
+        uint16 transitions = 0; // 1-based slot in g_Transitions, 0 = memoryless picks
+    };
+
+    // One layered edit: absolute value ("40") or signed delta ("+10", "-5") on top of the base.
+    template <typename T>
+    struct LayerEdit
+    {
+        bool set = false;
+        bool relative = false;
+        T value = T();
+
+        T Apply(T base) const { return !set ? base : (relative ? base + value : value); }
+    };
+
+    // Edits applied over a profile: season/daypart layers and per-zone overrides
+    struct ProfileLayer
+    {
+        std::array<LayerEdit<int32>, kStateCount> weights{};
+        LayerEdit<float> pctMin;
+        LayerEdit<float> pctMax;
+    };
+
+    constexpr size_t kSprinkleSlots = 4; // GM, event, script, spare
+
     struct Sprinkle
     {
-        bool active = false;
+        uint32 id = 0;                 // matched by the queued expiry
+        uint8 priority = 0;            // higher wins; the newest wins among equals
         WeatherState state = WEATHER_STATE_FINE;
         float pct = 0.0f; // 0..100 logical percent
-        uint32 remainMs = 0;
+        std::string tag;               // same tag replaces (e.g. "gm", "event", "boss")
+    };
+
+    // Fixed-capacity stack kept in priority order, so the active sprinkle is always slots[0].
+    struct SprinkleStack
+    {
+        std::array<Sprinkle, kSprinkleSlots> slots;
+        uint8 count = 0;
+
+        Sprinkle const* Top() const { return count ? &slots[0] : nullptr; }
+
+        void Erase(size_t i)
+        {
+            std::move(slots.begin() + i + 1, slots.begin() + count, slots.begin() + i);
+            --count;
+        }
+
+        bool Remove(uint32 id)
+        {
+            for (size_t i = 0; i < count; ++i)
+                if (slots[i].id == id) { Erase(i); return true; }
+            return false;
+        }
+
+        // Empty tag removes everything; returns how many were removed.
+        uint32 RemoveTag(std::string_view tag)
+        {
+            uint32 removed = 0;
+            for (size_t i = count; i-- > 0;)
+                if (tag.empty() || slots[i].tag == tag) { Erase(i); ++removed; }
+            return removed;
+        }
+
+        // False when full of higher-priority entries; otherwise the lowest one is dropped if needed.
+        bool Push(Sprinkle s)
+        {
+            RemoveTag(s.tag);
+            if (count == kSprinkleSlots)
+            {
+                if (s.priority < slots[count - 1].priority) return false;
+                --count;
+            }
+
+            size_t at = 0;
+            while (at < count && slots[at].priority > s.priority) ++at;
+            std::move_backward(slots.begin() + at, slots.begin() + count, slots.begin() + count + 1);
+            slots[at] = std::move(s);
+            ++count;
+            return true;
+        }
+    };
+
+    // Scripted timeline layer: replaces the auto pick while active, a sprinkle still wins over it.
+    struct TimelineOverlay
+    {
+        bool active = false;
+        WeatherState state = WEATHER_STATE_FINE;
+        float pct = 0.0f;  // 0..100 logical percent
+        uint32 owner = 0;  // index into g_Timelines
     };
 
     struct AutoZone
     {
         bool enabled = false;          // zone is controlled by auto engine
         std::string profile;           // profile name
+        std::shared_ptr<Profile const> effective; // what the tick reads: the shared base profile, or an owned
+                                                  // flattened copy when the zone has an override; null = none
+        bool hasOverride = false;      // effective is the zone's own copy
 
         // Current logical percent + state (percent is profile-space, 0..100)
         WeatherState curState = WEATHER_STATE_FINE;
@@ -153,50 +444,409 @@ namespace
         // Target we are tweening toward
         WeatherState tgtState = WEATHER_STATE_FINE;
         float tgtPct = 0.0f;
-        uint32 windowRemainMs = 0;     // how long until a new target is chosen
-        uint32 tweenRemainMs = 0;      // time left to finish tween
+        uint64 windowEndMs = 0;        // engine time a new target is chosen
+        float tweenFromPct = 0.0f;     // curPct when the tween began
+        uint64 tweenStartMs = 0;       // engine clock at tween start
+        uint32 tweenMs = 0;            // tween length, 0 = at target
 
-        Sprinkle sprinkle;             // temporary override
+        SprinkleStack sprinkles;       // temporary overrides, top one applies
+        TimelineOverlay timeline;      // scripted event step (under sprinkle, over auto)
+        uint16 region = 0;             // 1-based slot in g_Regions, 0 = picks its own targets
 
         // book-keeping to clamp sends
         float lastRawSent = -1.0f;
         WeatherState lastStateSent = WEATHER_STATE_FINE;
+
+        // adaptive nudge (Auto.PacketBudget > 0): per-zone threshold steered by the observed send rate
+        float nudge = 0.01f;           // raw delta threshold in use
+        float sendRate = 0.0f;         // EWMA of sends, packets/minute, as of lastSendMs (decays in closed form)
+        uint64 lastSendMs = 0;         // engine time of the last send
+
+        // event-driven evaluation: the zone is only stepped when its queued wake fires
+        uint64 wakeMs = UINT64_MAX;    // earliest queued wake, UINT64_MAX = none
+        uint32 wakeGen = 0;            // queued wakes of an older generation are stale
+    };
+
+    // Min-heap of timestamped payloads on the engine clock (g_EngineNowMs); FIFO among equal times.
+    template <typename T>
+    class TimedQueue
+    {
+    public:
+        void Push(uint64 dueMs, T const& payload)
+        {
+            _heap.push_back({ dueMs, _seq++, payload });
+            std::push_heap(_heap.begin(), _heap.end(), Later);
+        }
+
+        bool HasDue(uint64 nowMs) const { return !_heap.empty() && _heap.front().dueMs <= nowMs; }
+        uint64 NextDueMs() const { return _heap.empty() ? UINT64_MAX : _heap.front().dueMs; }
+
+        // Precondition: HasDue(). O(log n).
+        T PopDue()
+        {
+            std::pop_heap(_heap.begin(), _heap.end(), Later);
+            T payload = std::move(_heap.back().payload);
+            _heap.pop_back();
+            return payload;
+        }
+
+        size_t Size() const { return _heap.size(); }
+        void Clear() { _heap.clear(); }
+
+    private:
+        struct Entry { uint64 dueMs; uint64 seq; T payload; };
+        static bool Later(Entry const& a, Entry const& b) { return a.dueMs != b.dueMs ? a.dueMs > b.dueMs : a.seq > b.seq; }
+
+        std::vector<Entry> _heap;
+        uint64 _seq = 0;
+    };
+
+    // ================= Regional spillover =================
+    // A front reaching a neighbour zone; fronts only live in the queue while propagating.
+    struct FrontArrival
+    {
+        uint32 node;       // dense controller index (g_SpillNodeZone)
+        uint32 frontId;
+        WeatherState state;
+        float pct;         // logical percent carried (already decayed for this hop)
+        uint8 hops;
+    };
+
+    // ================= Regions =================
+    // One simulation for a group of zones: the region picks the target, members follow it with a
+    // fixed per-zone offset plus per-pick noise. Members do no picking of their own.
+    struct Region
+    {
+        std::string name;
+        std::string profile;     // lowercased profile the region samples
+        Profile climate;         // copy of that profile (regions are few)
+        std::vector<uint32> zones; // member controller zones
+
+        WeatherState state = WEATHER_STATE_FINE; // last pick
+        float pct = 0.0f;
+        uint64 windowEndMs = 0;  // engine time of the next pick
+        uint32 pick = 0;         // picks so far; salts the per-zone noise
+    };
+
+    // A region pick reaching one member zone (staggered so members do not all turn at once).
+    struct RegionOrder
+    {
+        uint32 zone;
+        uint16 region;     // 1-based slot in g_Regions
+        WeatherState state;
+        float pct;
+        uint32 pick;
+    };
+
+    // ================= Timelines =================
+    struct TimelineStep
+    {
+        WeatherState state;
+        float pct;          // 0..100 logical percent
+        uint32 durationMs;
+    };
+
+    struct Timeline
+    {
+        std::string name;
+        std::vector<uint32> zones;        // as configured; resolved to controllers when applied
+        std::vector<TimelineStep> steps;
+        int32 startMinute = -1;           // daily local start, -1 = command only
+        uint32 run = 0;                   // id of the running instance, 0 = idle
+        uint32 step = 0;                  // step currently applied (while running)
+    };
+
+    enum class TimelineAction : uint8 { DailyStart, Step };
+
+    struct TimelineEvent
+    {
+        uint32 timeline;   // index into g_Timelines
+        uint32 run;        // stale when it differs from the timeline's run (stopped/restarted)
+        uint32 step;
+        TimelineAction action;
+    };
+
+    // ================= Profile pack =================
+    // Versioned binary snapshot of the climate catalog (see WriteProfilePack()).
+    // Padding-free POD records in native byte order (a pack only moves between hosts of the same
+    // endianness): header, ranges, profiles, zone map, parents.
+    constexpr char   kPackMagic[4] = { 'W', 'V', 'P', 'K' };
+    constexpr uint32 kPackVersion = 4; // v2: per (season, daypart) cells, v3: spillover links, v4: no alias columns
+    constexpr size_t kPackNameLen = 32;
+    constexpr size_t kPackMaxBytes = 64u << 20; // far above any real catalog; rejects devices/dirs before allocating
+
+    struct PackHeader
+    {
+        char   magic[4];
+        uint32 version;
+        uint32 stateCount;
+        uint32 dayPartCount;
+        uint32 seasonCount;
+        uint32 profileCount;
+        uint32 zoneMapCount;
+        uint32 parentCount;
+        uint32 checksum;       // FNV-1a over everything after the header
+        uint32 linkCount;
+    };
+
+    struct PackCell
+    {
+        uint32 weights[kStateCount];
+        float  pctMin;
+        float  pctMax;
+    };
+
+    struct PackProfile
+    {
+        char     name[kPackNameLen]; // original case, NUL padded
+        PackCell cells[kProfileCells];
     };
 
+    struct PackPair { uint32 key; uint32 value; }; // zone->profile index, child->parent, zone<->zone link
+
+    static_assert(sizeof(PackHeader) == 40 && sizeof(PackCell) == 56 && sizeof(PackProfile) == 32 + 56 * kProfileCells && sizeof(PackPair) == 8, "pack records must stay padding-free");
+    static_assert(sizeof(Range) == 2 * sizeof(float), "ranges are bulk-copied from the pack");
+
     // engine globals
     bool   g_EnableModule = true;
     bool   g_Debug = false;
+    bool   g_PersonalEnabled = true;  // WeatherVibe.Personal.Enable
 
-    std::string  g_DayPartMode = "auto";  // auto|morning|afternoon|evening|night
-    std::string  g_SeasonMode = "auto";   // auto|spring|summer|autumn|winter
+    // in-memory per-character settings (guid low -> prefs; default settings are not stored)
+    std::unordered_map<uint32, PlayerPrefs> g_PlayerPrefs;
+    std::unordered_map<uint32, uint32> g_PersonalizedOnline;   // guid low -> zone, online players with prefs
+    std::unordered_map<uint32, uint32> g_PersonalizedPerZone;  // zone -> count of the above
 
-    DayPartStarts g_Starts;
+    // Daypart boundary blending: per minute-of-day (from, to, t), rebuilt on config load
+    struct MinuteBlend
+    {
+        DayPart from = DayPart::MORNING;
+        DayPart to = DayPart::MORNING;   // == from outside blend windows
+        float t = 0.0f;                  // 0 = from, 1 = to
+    };
 
-    // Per-daypart per-WeatherState ranges (keyed by WeatherState value: 0,1,3,4,5,6,7,8,22,41,42,86)
-    std::unordered_map<uint32, Range> g_StateRanges[(size_t)DayPart::COUNT];
+    constexpr int kMinutesPerDay = 24 * 60;
 
-    // per-zone last applied snapshot (for resend)
-    std::unordered_map<uint32, LastApplied>  g_LastApplied;
+    // Visual quantization (WeatherVibe.Quantize.*): per dense state, evenly spaced levels over the state's
+    // InternalRange envelope (all dayparts); the auto engine only sends these grades, one prebuilt packet each.
+    struct QuantTable
+    {
+        float lo = 0.0f;
+        float step = 0.0f;
+        std::vector<float> grades;        // empty = not quantized
+        std::vector<WorldPacket> packets; // packets[level]
+    };
+    constexpr uint32 kMaxQuantLevels = 255;
 
-    // zone parent mapping: child -> parent, and reverse registry parent -> children
-    std::unordered_map<uint32, uint32> g_ZoneParent; // child->parent
-    std::unordered_map<uint32, std::vector<uint32>> g_ZoneChildren; // parent->children
+    // area (sub-zone) controllers: an area id is its own controller key in g_AutoZones/g_LastApplied
+    // (AreaTable ids are unique across zones and areas); slot 0 = not controlled
+    struct AreaController
+    {
+        uint32 area = 0;
+        uint32 zone = 0;        // zone the area lies in (AreaTable)
+        std::string profile;    // lowercased
+    };
+
+    // Everything a config load produces and nothing else: loaders fill a ConfigTables, so a reload can
+    // compile a fresh one off the world thread and install it by swapping it with g_Tables.
+    struct ConfigTables
+    {
+        // parsed WeatherVibe.DayPart.Mode / WeatherVibe.Season; COUNT = auto (clock/date driven)
+        DayPart forcedDayPart = DayPart::COUNT;
+        Season  forcedSeason = Season::COUNT;
+        DayPartStarts starts;
+        uint32 blendMinutes = 0;        // WeatherVibe.DayPart.BlendMinutes, 0 = instant switch
+        std::array<MinuteBlend, kMinutesPerDay> dayBlend{};
+
+        // Per-daypart per-WeatherState ranges (indexed by dense state index, see StateIndex())
+        Range stateRanges[(size_t)DayPart::COUNT][kStateCount];
+
+        uint32 quantizeLevels = 0;      // WeatherVibe.Quantize.Levels, 0 = off
+        std::array<QuantTable, kStateCount> quant;
+
+        // zone parent mapping: child -> parent, and reverse registry parent -> children
+        std::unordered_map<uint32, uint32> zoneParent;
+        std::unordered_map<uint32, std::vector<uint32>> zoneChildren;
+
+        // profiles + zone assignment for auto engine
+        std::unordered_map<std::string, std::shared_ptr<Profile>> profiles; // by name lowercased; zones share them
+        std::unordered_map<uint32, std::string> zoneProfile;    // controller zone -> profile name (lower)
+        std::unordered_map<uint32, ProfileLayer> zoneOverrides; // controller zone -> deltas over its profile
+        std::vector<TransitionTable> transitions;               // Profile.<Name>.Next.* rows
+
+        std::vector<AreaController> areaControllers = std::vector<AreaController>(1);
+        std::vector<uint16> areaSlot;   // area id -> slot, sized to the largest configured area + 1
+
+        // optional precompiled pack replacing the catalog keys (ranges/profiles/zone map/parents)
+        std::string packFile;           // WeatherVibe.Pack.File, empty = parse config strings
+        bool        packActive = false; // last load came from the pack
+
+        // auto engine control
+        bool   autoEnabled = false;
+        uint32 autoTickMs = 1000;       // tick granularity
+        uint32 minWindowSec = 180;
+        uint32 maxWindowSec = 480;
+        uint32 tweenSec = 20;
+        TweenCurve tweenCurve = TweenCurve::LINEAR;
+        float  tinyNudge = 0.01f;       // raw delta skip threshold
+
+        // adaptive nudge: 0 budget = fixed TinyNudge
+        float  packetBudget = 0.0f;     // target packets/minute per zone
+        float  nudgeMin = 0.002f;
+        float  nudgeMax = 0.10f;
+        uint32 rateWindowSec = 60;      // EWMA time constant
+        uint32 minSendIntervalMs = 0;   // 60000 / budget; same-state sends closer than this are held back
+
+        // regional spillover: zone adjacency in CSR form over dense controller indices
+        bool   spillEnabled = false;
+        uint32 spillDelaySec = 120;     // per hop
+        float  spillDecay = 0.7f;       // percent multiplier per hop
+        float  spillTriggerPct = 35.0f; // min target percent that starts a front
+        float  spillMinPct = 15.0f;     // fronts weaker than this stop
+        uint32 spillMaxHops = 3;
+        std::vector<std::pair<uint32, uint32>> spillLinks; // configured undirected links (zone ids)
+        std::unordered_map<uint32, uint32> spillZoneNode;  // controller zone -> node
+        std::vector<uint32> spillNodeZone;                 // node -> controller zone
+        std::vector<uint32> spillAdjOffsets;               // node -> [offsets[n], offsets[n+1]) in spillAdj
+        std::vector<uint32> spillAdj;                      // neighbour nodes
+
+        // regions: few simulations driving many member zones
+        float  regionSpreadPct = 10.0f; // max fixed per-zone offset from the region percent
+        float  regionNoisePct = 5.0f;   // max per-pick noise on top
+        uint32 regionStaggerSec = 90;   // members take a pick over this many seconds
+    };
+
+    ConfigTables g_Tables; // installed tables; the engine reads them through the names below
+
+    DayPart& g_ForcedDayPart = g_Tables.forcedDayPart;
+    Season&  g_ForcedSeason = g_Tables.forcedSeason;
+    DayPartStarts& g_Starts = g_Tables.starts;
+    uint32& g_BlendMinutes = g_Tables.blendMinutes;
+    std::array<MinuteBlend, kMinutesPerDay>& g_DayBlend = g_Tables.dayBlend;
+    Range (&g_StateRanges)[(size_t)DayPart::COUNT][kStateCount] = g_Tables.stateRanges;
+    uint32& g_QuantizeLevels = g_Tables.quantizeLevels;
+    std::array<QuantTable, kStateCount>& g_Quant = g_Tables.quant;
+    std::unordered_map<uint32, uint32>& g_ZoneParent = g_Tables.zoneParent;
+    std::unordered_map<uint32, std::vector<uint32>>& g_ZoneChildren = g_Tables.zoneChildren;
+    std::unordered_map<std::string, std::shared_ptr<Profile>>& g_Profiles = g_Tables.profiles;
+    std::unordered_map<uint32, std::string>& g_ZoneProfile = g_Tables.zoneProfile;
+    std::unordered_map<uint32, ProfileLayer>& g_ZoneOverrides = g_Tables.zoneOverrides;
+    std::vector<TransitionTable>& g_Transitions = g_Tables.transitions;
+    std::vector<AreaController>& g_AreaControllers = g_Tables.areaControllers;
+    std::vector<uint16>& g_AreaSlot = g_Tables.areaSlot;
+    std::string& g_PackFile = g_Tables.packFile;
+    bool&   g_PackActive = g_Tables.packActive;
+    bool&   g_AutoEnabled = g_Tables.autoEnabled;
+    uint32& g_AutoTickMs = g_Tables.autoTickMs;
+    uint32& g_MinWindowSec = g_Tables.minWindowSec;
+    uint32& g_MaxWindowSec = g_Tables.maxWindowSec;
+    uint32& g_TweenSec = g_Tables.tweenSec;
+    TweenCurve& g_TweenCurve = g_Tables.tweenCurve;
+    float&  g_TinyNudge = g_Tables.tinyNudge;
+    float&  g_PacketBudget = g_Tables.packetBudget;
+    float&  g_NudgeMin = g_Tables.nudgeMin;
+    float&  g_NudgeMax = g_Tables.nudgeMax;
+    uint32& g_RateWindowSec = g_Tables.rateWindowSec;
+    uint32& g_MinSendIntervalMs = g_Tables.minSendIntervalMs;
+    bool&   g_SpillEnabled = g_Tables.spillEnabled;
+    uint32& g_SpillDelaySec = g_Tables.spillDelaySec;
+    float&  g_SpillDecay = g_Tables.spillDecay;
+    float&  g_SpillTriggerPct = g_Tables.spillTriggerPct;
+    float&  g_SpillMinPct = g_Tables.spillMinPct;
+    uint32& g_SpillMaxHops = g_Tables.spillMaxHops;
+    std::vector<std::pair<uint32, uint32>>& g_SpillLinks = g_Tables.spillLinks;
+    std::unordered_map<uint32, uint32>& g_SpillZoneNode = g_Tables.spillZoneNode;
+    std::vector<uint32>& g_SpillNodeZone = g_Tables.spillNodeZone;
+    std::vector<uint32>& g_SpillAdjOffsets = g_Tables.spillAdjOffsets;
+    std::vector<uint32>& g_SpillAdj = g_Tables.spillAdj;
+    float&  g_RegionSpreadPct = g_Tables.regionSpreadPct;
+    float&  g_RegionNoisePct = g_Tables.regionNoisePct;
+    uint32& g_RegionStaggerSec = g_Tables.regionStaggerSec;
+
+    // Ranges in effect right now (blended across daypart boundaries); refreshed once per minute
+    Range g_ActiveRanges[kStateCount];
+    int   g_ActiveRangesKey = -1;        // minute-of-day (or kMinutesPerDay + forced daypart), -1 = stale
 
-    // profiles + zone assignment for auto engine
-    std::unordered_map<std::string, Profile> g_Profiles; // by name lowercased
-    std::unordered_map<uint32, std::string> g_ZoneProfile; // controller zone -> profile name (lower)
+    // per-zone last applied snapshot (for resend)
+    LastAppliedStore g_LastApplied;
 
-    // auto engine control
-    bool   g_AutoEnabled = false;
-    uint32 g_AutoTickMs = 1000;     // tick granularity
-    uint32 g_MinWindowSec = 180;
-    uint32 g_MaxWindowSec = 480;
-    uint32 g_TweenSec = 20;
-    float  g_TinyNudge = 0.01f;  // raw delta skip threshold
+    // players standing in controlled areas; they are skipped by their zone's broadcast
+    struct AreaSeat
+    {
+        uint16 slot = 0;    // 0 = not in a controlled area (entry kept until logout)
+        uint32 index = 0;   // position in g_AreaPlayers[slot], for O(1) removal
+    };
+    std::vector<std::vector<ObjectGuid>> g_AreaPlayers;       // slot -> players
+    std::unordered_map<uint32, AreaSeat> g_PlayerAreaSeat;    // guid low -> seat
+    std::unordered_map<uint32, uint32> g_AreaOccupiedPerZone; // zone -> players inside its controlled areas (may be 0)
 
     std::unordered_map<uint32, AutoZone> g_AutoZones; // only controller zones
 
     std::mt19937 g_Rng{ std::random_device{}() };
+
+    // engine clock: advanced by ApplyAutoTick, drives every TimedQueue
+    uint64 g_EngineNowMs = 0;
+
+    // spillover runtime (the graph itself is in g_Tables)
+    std::vector<uint32> g_SpillNodeFront;                    // last front id seen per node (no revisits)
+    TimedQueue<FrontArrival> g_Fronts;
+    uint32 g_NextFrontId = 1;
+
+    // regions: few simulations driving many member zones (knobs in g_Tables)
+    std::vector<Region> g_Regions;
+    TimedQueue<RegionOrder> g_RegionOrders;
+
+    // scripted timelines (config or .wvibe timeline run); every step/start is a queued event
+    std::vector<Timeline> g_Timelines;
+    TimedQueue<TimelineEvent> g_TimelineQueue;
+    uint32 g_NextTimelineRun = 1;
+
+    // sprinkle expiries, keyed by sprinkle id (removed/replaced sprinkles just miss)
+    struct SprinkleExpiry { uint32 zone; uint32 id; };
+    TimedQueue<SprinkleExpiry> g_SprinkleExpiry;
+    uint32 g_NextSprinkleId = 1;
+
+    // zone wake-ups: a zone is stepped only when something can change what it shows
+    struct ZoneWake { uint32 zone; uint32 gen; };
+    TimedQueue<ZoneWake> g_ZoneWakes;
+    std::vector<ZoneWake> g_NextTickWakes; // fast lane for zones mid-ramp, which step again on the next tick
+    uint32 g_WakeGen = 0;                  // global, so a pruned and re-created zone never matches old wakes
+
+    // (profile cell, blended ranges) the zones were last evaluated against; a change wakes every zone
+    struct ContextWatch
+    {
+        size_t cellIndex = SIZE_MAX;
+        std::array<Range, kStateCount> ranges{};
+    };
+    ContextWatch g_LiveContext;
+
+    // background commands: the task returns a finish step, run on the world thread with the requester's
+    // handler (nullptr when they logged out meanwhile)
+    using CommandFinish = std::function<void(ChatHandler*)>;
+    struct PendingCommand
+    {
+        ObjectGuid requester;
+        std::future<CommandFinish> result;
+    };
+    std::vector<PendingCommand> g_PendingCommands;
+    bool g_ReloadPending = false; // one reload task at a time
+
+    // long diagnostics (sim, loadtest, selftest) run a slice per world update; step returns the finish
+    // step once done, an empty one while work remains
+    using SliceClock = std::chrono::steady_clock;
+    using CommandSlice = std::function<CommandFinish(SliceClock::time_point deadline)>;
+    struct SlicedCommand
+    {
+        ObjectGuid requester;
+        CommandSlice step;
+    };
+    std::deque<SlicedCommand> g_SlicedCommands;
+
+    // config parse bookkeeping (reset on every load, reported by reload/bench); per thread, since a
+    // reload parses on a background task
+    thread_local uint32 g_ParseErrors = 0;
+    thread_local bool   g_ParseQuiet = false; // bench re-runs count errors without re-logging them
+    thread_local ConfigSnapshot const* g_ConfigView = nullptr; // what the running parse reads
 }
 
 // ======================================
@@ -236,6 +886,16 @@ static char const* SeasonName(Season s)
     }
 }
 
+static char const* TweenCurveName(TweenCurve c)
+{
+    switch (c)
+    {
+    case TweenCurve::SMOOTHSTEP: return "smoothstep";
+    case TweenCurve::EASE_IN_OUT: return "easeinout";
+    default: return "linear";
+    }
+}
+
 static char const* DayPartName(DayPart d)
 {
     switch (d)
@@ -260,6 +920,23 @@ static char const* DayPartTokenUpper(DayPart d)
     }
 }
 
+static char const* SeasonTokenUpper(Season s)
+{
+    switch (s)
+    {
+    case Season::SPRING: return "SPRING";
+    case Season::SUMMER: return "SUMMER";
+    case Season::AUTUMN: return "AUTUMN";
+    case Season::WINTER: return "WINTER";
+    default:             return "UNKNOWN";
+    }
+}
+
+static inline size_t CellIndex(Season s, DayPart d)
+{
+    return (size_t)s * (size_t)DayPart::COUNT + (size_t)d;
+}
+
 static char const* ConfigStateToken(WeatherState s)
 {
     switch (s)
@@ -304,692 +981,4742 @@ static bool IsValidWeatherState(uint32 value)
     }
 }
 
+// Dense index of a state inside kAcceptedStates (kStateCount when not accepted).
+static size_t StateIndex(uint32 value)
+{
+    switch (value)
+    {
+    case WEATHER_STATE_FINE:             return 0;
+    case WEATHER_STATE_FOG:              return 1;
+    case WEATHER_STATE_LIGHT_RAIN:       return 2;
+    case WEATHER_STATE_MEDIUM_RAIN:      return 3;
+    case WEATHER_STATE_HEAVY_RAIN:       return 4;
+    case WEATHER_STATE_LIGHT_SNOW:       return 5;
+    case WEATHER_STATE_MEDIUM_SNOW:      return 6;
+    case WEATHER_STATE_HEAVY_SNOW:       return 7;
+    case WEATHER_STATE_LIGHT_SANDSTORM:  return 8;
+    case WEATHER_STATE_MEDIUM_SANDSTORM: return 9;
+    case WEATHER_STATE_HEAVY_SANDSTORM:  return 10;
+    case WEATHER_STATE_THUNDERS:         return 11;
+    default:                             return kStateCount;
+    }
+}
+
 // ======================================
-// Time helpers
+// Config tokenizer (string_view based; no per-token allocations)
 // ======================================
-static tm GetLocalTimeSafe()
+static std::string_view TrimView(std::string_view s)
 {
-    time_t now = GameTime::GetGameTime().count(); // unix seconds
-    tm out{};
-#if defined(_WIN32) || defined(_WIN64)
-    localtime_s(&out, &now);
-#else
-    localtime_r(&now, &out);
-#endif
-    return out;
+    size_t a = s.find_first_not_of(" \t\n\r");
+    if (a == std::string_view::npos) return {};
+    size_t b = s.find_last_not_of(" \t\n\r");
+    return s.substr(a, b - a + 1);
 }
 
-static int ParseHHMM(std::string const& s, int defMinutes)
+static std::string Lower(std::string s)
 {
-    int h = 0, m = 0; char colon = 0;
-    std::string t = s;
-    t.erase(std::remove_if(t.begin(), t.end(), [](unsigned char c) { return std::isspace(c); }), t.end());
-
-    if (std::sscanf(t.c_str(), "%d%c%d", &h, &colon, &m) == 3 && colon == ':' && h >= 0 && h < 24 && m >= 0 && m < 60)
-    {
-        return h * 60 + m;
-    }
-
-    if (std::sscanf(t.c_str(), "%d", &h) == 1 && h >= 0 && h < 24)
-    {
-        return h * 60;
-    }
-
-    return defMinutes;
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+    return s;
 }
 
-static inline int ClampMinutes(int v) { return std::clamp(v, 0, 23 * 60 + 59); }
-static void ValidateDayPartStarts()
+// ASCII case-insensitive equality, without building lowered copies.
+static bool EqualsNoCase(std::string_view a, std::string_view b)
 {
-    g_Starts.morning = ClampMinutes(g_Starts.morning);
-    g_Starts.afternoon = std::max(ClampMinutes(g_Starts.afternoon), g_Starts.morning + 1);
-    g_Starts.evening = std::max(ClampMinutes(g_Starts.evening), g_Starts.afternoon + 1);
-    g_Starts.night = std::max(ClampMinutes(g_Starts.night), g_Starts.evening + 1);
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(),
+        [](unsigned char x, unsigned char y) { return std::tolower(x) == std::tolower(y); });
 }
 
-// ======================================
-// Intensity mapping helpers
-// ======================================
-static float ClampToCoreBounds(float g, WeatherState s)
+// Lowercases src into dst, reusing dst's capacity.
+static void AssignLower(std::string& dst, std::string_view src)
 {
-    // Allow true 0.0 for FINE (perfectly clear), clamp others conservatively
-    if (s == WEATHER_STATE_FINE)
-        return std::clamp(g, 0.0f, 0.9999f);
-
-    if (g < 0.0f)  return kMinGrade;
-    if (g >= 1.0f) return kMaxGrade;
-    return g;
+    dst.assign(src);
+    std::transform(dst.begin(), dst.end(), dst.begin(), [](unsigned char c) { return char(std::tolower(c)); });
 }
 
-static void LoadDayPartConfig()
+// Calls fn(token, index) for every non-empty, trimmed token separated by `sep`.
+template <typename Fn>
+static void ForEachToken(std::string_view s, char sep, Fn&& fn)
 {
-    g_DayPartMode = sConfigMgr->GetOption<std::string>("WeatherVibe.DayPart.Mode", "auto");
-    g_SeasonMode = sConfigMgr->GetOption<std::string>("WeatherVibe.Season", "auto");
-
-    g_Starts.morning = ParseHHMM(sConfigMgr->GetOption<std::string>("WeatherVibe.DayPart.MORNING.Start", "06:00"), 6 * 60);
-    g_Starts.afternoon = ParseHHMM(sConfigMgr->GetOption<std::string>("WeatherVibe.DayPart.AFTERNOON.Start", "12:00"), 12 * 60);
-    g_Starts.evening = ParseHHMM(sConfigMgr->GetOption<std::string>("WeatherVibe.DayPart.EVENING.Start", "18:00"), 18 * 60);
-    g_Starts.night = ParseHHMM(sConfigMgr->GetOption<std::string>("WeatherVibe.DayPart.NIGHT.Start", "22:00"), 22 * 60);
+    size_t index = 0;
+    while (!s.empty())
+    {
+        size_t cut = s.find(sep);
+        std::string_view tok = TrimView(s.substr(0, cut));
+        if (!tok.empty())
+            fn(tok, index++);
+        if (cut == std::string_view::npos)
+            break;
+        s.remove_prefix(cut + 1);
+    }
+}
 
-    ValidateDayPartStarts();
+// Splits "lhs<sep>rhs" at the first separator; both sides trimmed and non-empty.
+static bool SplitPair(std::string_view tok, char sep, std::string_view& lhs, std::string_view& rhs)
+{
+    size_t cut = tok.find(sep);
+    if (cut == std::string_view::npos) return false;
+    lhs = TrimView(tok.substr(0, cut));
+    rhs = TrimView(tok.substr(cut + 1));
+    return !lhs.empty() && !rhs.empty();
 }
 
-static Range ParseRangePair(std::string const& key, Range def)
+// Whole-token number parse. Floating-point std::from_chars is missing from older libc++ (Apple
+// clang), so there floats go through strtof on a stack copy with the same accept rules.
+template <typename T>
+static bool NumberFromChars(std::string_view s, T& out)
 {
-    std::string v = sConfigMgr->GetOption<std::string>(key, "");
-    if (!v.empty())
+#if !defined(__cpp_lib_to_chars)
+    if constexpr (std::is_floating_point_v<T>)
     {
-        float a = def.min, b = def.max;
-        if (std::sscanf(v.c_str(), " %f , %f ", &a, &b) == 2)
-        {
-            if (b < a) std::swap(a, b);
-            return { std::clamp(a,0.0f,1.0f), std::clamp(b,0.0f,1.0f) };
-        }
+        char buf[64];
+        if (s.empty() || s.size() >= sizeof(buf) || s.front() == '+' || std::isspace((unsigned char)s.front()))
+            return false;
+        std::memcpy(buf, s.data(), s.size());
+        buf[s.size()] = '\0';
+        char* end = nullptr;
+        errno = 0;
+        T v = std::is_same_v<T, float> ? T(std::strtof(buf, &end)) : T(std::strtod(buf, &end));
+        if (end != buf + s.size() || errno == ERANGE)
+            return false;
+        out = v;
+        return true;
+    }
+    else
+#endif
+    {
+        auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), out);
+        return !s.empty() && ec == std::errc() && end == s.data() + s.size();
     }
-    return def;
 }
 
-static std::array<WeatherState, 12> const kAcceptedStates = {
-    WEATHER_STATE_FINE,
-    WEATHER_STATE_FOG,
-    WEATHER_STATE_LIGHT_RAIN,
-    WEATHER_STATE_MEDIUM_RAIN,
-    WEATHER_STATE_HEAVY_RAIN,
-    WEATHER_STATE_LIGHT_SNOW,
-    WEATHER_STATE_MEDIUM_SNOW,
-    WEATHER_STATE_HEAVY_SNOW,
-    WEATHER_STATE_LIGHT_SANDSTORM,
-    WEATHER_STATE_MEDIUM_SANDSTORM,
-    WEATHER_STATE_HEAVY_SANDSTORM,
-    WEATHER_STATE_THUNDERS
-};
-
-static void LoadStateRanges()
+static bool ParseUInt(std::string_view s, uint32& out)
 {
-    // clear previous
-    for (size_t i = 0; i < (size_t)DayPart::COUNT; ++i)
-        g_StateRanges[i].clear();
+    return NumberFromChars(TrimView(s), out);
+}
 
-    auto makeKey = [](DayPart dp, WeatherState ws)
-        {
-            std::ostringstream oss;
-            oss << "WeatherVibe.Intensity.InternalRange."
-                << DayPartTokenUpper(dp) << "."
-                << ConfigStateToken(ws);
-            return oss.str();
-        };
+static bool ParseFloat(std::string_view s, float& out)
+{
+    return NumberFromChars(TrimView(s), out);
+}
 
-    Range def{ 0.30f, 1.00f }; // sensible defaults; expect config to reduce to ~0.65 tops
+// Numeric id ("86") or state name ("thunders", "light_rain"), case-insensitive.
+static bool ParseStateToken(std::string_view s, WeatherState& out)
+{
+    uint32 val = 0;
+    if (ParseUInt(s, val))
+    {
+        if (!IsValidWeatherState(val)) return false;
+        out = static_cast<WeatherState>(val);
+        return true;
+    }
 
-    for (DayPart dp : { DayPart::MORNING, DayPart::AFTERNOON, DayPart::EVENING, DayPart::NIGHT })
-        for (WeatherState ws : kAcceptedStates)
-            g_StateRanges[(size_t)dp][(uint32)ws] = ParseRangePair(makeKey(dp, ws), def);
+    s = TrimView(s);
+    for (WeatherState ws : kAcceptedStates)
+        if (EqualsNoCase(s, WeatherStateName(ws))) { out = ws; return true; }
+    return false;
 }
 
-// Converts profile percent (0..1) to raw grade (per-WeatherState/daypart range)
-static float MapPercentToRawGrade(DayPart dp, WeatherState state, float percent01)
+// "40" (absolute) or "+10"/"-5" (delta) into a layered edit
+template <typename T>
+static bool ParseLayerEdit(std::string_view s, LayerEdit<T>& out)
 {
-    percent01 = std::clamp(percent01, 0.0f, 1.0f);
-    auto const& table = g_StateRanges[(size_t)dp];
-    auto it = table.find((uint32)state);
-    Range r;
+    s = TrimView(s);
+    bool relative = !s.empty() && (s.front() == '+' || s.front() == '-');
+    bool negative = !s.empty() && s.front() == '-';
+    if (relative) s.remove_prefix(1);
 
-    if (it != table.end()) r = it->second; else r = { 0.30f, 1.00f };
+    T v{};
+    if (!NumberFromChars(s, v) || v < T())
+        return false;
 
-    return r.min + percent01 * (r.max - r.min);
+    out.set = true;
+    out.relative = relative;
+    out.value = negative ? -v : v;
+    return true;
 }
 
-static float RawToPercent01(DayPart dp, WeatherState state, float raw)
+// Logs one malformed entry of a config key; entries are 1-based in the message.
+static void ReportParseError(std::string_view key, size_t index, std::string_view token, char const* reason)
 {
-    auto const& table = g_StateRanges[(size_t)dp];
-    auto it = table.find((uint32)state);
-    Range r = (it != table.end()) ? it->second : Range{ 0.0f, 1.0f };
-    if (r.max <= r.min) return 0.0f;
-    return std::clamp((raw - r.min) / (r.max - r.min), 0.0f, 1.0f);
+    ++g_ParseErrors;
+    if (!g_ParseQuiet)
+        LOG_ERROR("server.loading", "[WeatherVibe] {}: entry #{} '{}' {}", key, index + 1, token, reason);
 }
 
 // ======================================
-// Day/Season helpers used by debug/show
+// Config snapshot (what every parse reads)
 // ======================================
-static Season GetCurrentSeason()
+// Every WeatherVibe.* option, copied on the world thread: `.reload config` rewrites the ConfigMgr
+// there, so a parse running on a background task must not read it. Values convert as in
+// ConfigMgr::GetOption; a malformed number falls back to the default.
+class ConfigSnapshot
 {
-    std::string m = g_SeasonMode;
-    std::transform(m.begin(), m.end(), m.begin(), [](unsigned char c) { return char(std::tolower(c)); });
-
-    if (m == "spring") return Season::SPRING;
-    if (m == "summer") return Season::SUMMER;
-    if (m == "autumn") return Season::AUTUMN;
-    if (m == "winter") return Season::WINTER;
+public:
+    static std::shared_ptr<ConfigSnapshot const> Take()
+    {
+        auto snap = std::make_shared<ConfigSnapshot>();
+        for (std::string const& key : sConfigMgr->GetKeysByString("WeatherVibe."))
+            snap->_values[key] = sConfigMgr->GetOption<std::string>(key, "");
+        return snap;
+    }
 
-    tm lt = GetLocalTimeSafe();
-    int yday = lt.tm_yday;
-    uint32 seasonIndex = ((yday - 78 + 365) / 91) % 4; // ~Mar 20 as 0
+    // Raw text of an option, viewing the snapshot's own copy (valid while the snapshot lives).
+    std::string_view Text(std::string const& key, std::string_view def) const
+    {
+        auto it = _values.find(key);
+        return it == _values.end() ? def : std::string_view(it->second);
+    }
 
-    switch (seasonIndex)
+    template <typename T>
+    T Get(std::string const& key, T const& def) const
     {
-    default:
-    case 0: return Season::SPRING;
-    case 1: return Season::SUMMER;
-    case 2: return Season::AUTUMN;
-    case 3: return Season::WINTER;
+        auto it = _values.find(key);
+        if (it == _values.end())
+            return def;
+
+        std::string_view v = TrimView(it->second);
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            for (std::string_view yes : { "1", "true", "yes", "on", "y" })
+                if (EqualsNoCase(v, yes))
+                    return true;
+            for (std::string_view no : { "0", "false", "no", "off", "n" })
+                if (EqualsNoCase(v, no))
+                    return false;
+            return def;
+        }
+        else
+        {
+            T out{};
+            return NumberFromChars(v, out) ? out : def;
+        }
     }
-}
 
-static DayPart GetCurrentDayPart()
+private:
+    std::unordered_map<std::string, std::string> _values;
+};
+
+// Points this thread's config reads at a snapshot for the scope's lifetime.
+class ConfigSnapshotScope
 {
-    std::string mode = g_DayPartMode;
-    std::transform(mode.begin(), mode.end(), mode.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+public:
+    explicit ConfigSnapshotScope(ConfigSnapshot const& cfg) : _prev(g_ConfigView) { g_ConfigView = &cfg; }
+    ~ConfigSnapshotScope() { g_ConfigView = _prev; }
 
-    if (mode == "morning")   return DayPart::MORNING;
-    if (mode == "afternoon") return DayPart::AFTERNOON;
-    if (mode == "evening")   return DayPart::EVENING;
-    if (mode == "night")     return DayPart::NIGHT;
+    ConfigSnapshotScope(ConfigSnapshotScope const&) = delete;
+    ConfigSnapshotScope& operator=(ConfigSnapshotScope const&) = delete;
 
-    tm lt = GetLocalTimeSafe();
-    int minutes = lt.tm_hour * 60 + lt.tm_min;
+private:
+    ConfigSnapshot const* _prev;
+};
 
-    if (minutes >= g_Starts.night || minutes < g_Starts.morning) return DayPart::NIGHT;
-    if (minutes >= g_Starts.evening)   return DayPart::EVENING;
-    if (minutes >= g_Starts.afternoon) return DayPart::AFTERNOON;
-    return DayPart::MORNING;
+// Option reads for the loaders; only valid inside a ConfigSnapshotScope (a loader reading the live
+// ConfigMgr could race a `.reload config` on the world thread).
+template <typename T>
+static T ConfigOption(std::string const& key, T const& def)
+{
+    ASSERT(g_ConfigView, "WeatherVibe config read outside a ConfigSnapshotScope: {}", key);
+    return g_ConfigView->Get<T>(key, def);
+}
+
+// String options as views into the snapshot: list keys are tokenized in place, never copied.
+static std::string_view ConfigText(std::string const& key, std::string_view def)
+{
+    ASSERT(g_ConfigView, "WeatherVibe config read outside a ConfigSnapshotScope: {}", key);
+    return g_ConfigView->Text(key, def);
 }
 
 // ======================================
-// Zone parent mapping
+// Time helpers
 // ======================================
-static uint32 ResolveControllerZone(uint32 zoneId)
+static tm GetLocalTimeSafe()
 {
-    auto it = g_ZoneParent.find(zoneId);
-    if (it == g_ZoneParent.end()) return zoneId;
-    // chain-safe (in case of multi-level mapping)
-    uint32 cur = zoneId;
-    std::unordered_set<uint32> seen;
-    while (g_ZoneParent.count(cur))
+    time_t now = GameTime::GetGameTime().count(); // unix seconds
+    tm out{};
+#if defined(_WIN32) || defined(_WIN64)
+    localtime_s(&out, &now);
+#else
+    localtime_r(&now, &out);
+#endif
+    return out;
+}
+
+// "HH:MM" or "HH" -> minutes of day
+static int ParseHHMM(std::string_view s, int defMinutes)
+{
+    std::string_view hh, mm;
+    uint32 h = 0, m = 0;
+
+    if (SplitPair(s, ':', hh, mm))
     {
-        if (!seen.insert(cur).second) break; // cycle guard
-        cur = g_ZoneParent[cur];
+        if (ParseUInt(hh, h) && ParseUInt(mm, m) && h < 24 && m < 60)
+            return int(h * 60 + m);
     }
-    return cur;
+    else if (ParseUInt(s, h) && h < 24)
+    {
+        return int(h * 60);
+    }
+
+    return defMinutes;
+}
+
+static void ValidateDayPartStarts(DayPartStarts& starts)
+{
+    // leave room for the three later starts, so every daypart keeps at least one minute of the day
+    starts.morning = std::clamp(starts.morning, 0, kMinutesPerDay - 4);
+    starts.afternoon = std::clamp(starts.afternoon, starts.morning + 1, kMinutesPerDay - 3);
+    starts.evening = std::clamp(starts.evening, starts.afternoon + 1, kMinutesPerDay - 2);
+    starts.night = std::clamp(starts.night, starts.evening + 1, kMinutesPerDay - 1);
 }
 
 // ======================================
-// Applies weather to a zone (returns true only when actually delivered to at least one player).
+// Intensity mapping helpers
 // ======================================
-static bool PushWeatherToClient(uint32 zoneIdRaw, WeatherState state, float rawGrade)
+static float ClampToCoreBounds(float g, WeatherState s)
+{
+    // Allow true 0.0 for FINE (perfectly clear), clamp others conservatively
+    if (s == WEATHER_STATE_FINE)
+        return std::clamp(g, 0.0f, 0.9999f);
+
+    if (g < kMinGrade) return kMinGrade;
+    if (g >= 1.0f) return kMaxGrade;
+    return g;
+}
+
+static void LoadDayPartConfig(ConfigTables& t)
 {
-    uint32 zoneId = ResolveControllerZone(zoneIdRaw);
-    float normalizedGrade = ClampToCoreBounds(rawGrade, state);
+    std::string_view mode = TrimView(ConfigText("WeatherVibe.DayPart.Mode", "auto"));
+    t.forcedDayPart = DayPart::COUNT;
+    for (DayPart dp : { DayPart::MORNING, DayPart::AFTERNOON, DayPart::EVENING, DayPart::NIGHT })
+        if (EqualsNoCase(mode, DayPartName(dp)))
+            t.forcedDayPart = dp;
 
-    // We send to controller and children
-    WorldPackets::Misc::Weather weatherPackage(state, normalizedGrade);
-    bool delivered = sWorldSessionMgr->SendZoneMessage(zoneId, weatherPackage.Write());
-    auto itc = g_ZoneChildren.find(zoneId);
-    if (itc != g_ZoneChildren.end())
-        for (uint32 child : itc->second)
-            delivered = sWorldSessionMgr->SendZoneMessage(child, weatherPackage.Write()) || delivered;
+    std::string_view season = TrimView(ConfigText("WeatherVibe.Season", "auto"));
+    t.forcedSeason = Season::COUNT;
+    for (Season s : { Season::SPRING, Season::SUMMER, Season::AUTUMN, Season::WINTER })
+        if (EqualsNoCase(season, SeasonName(s)))
+            t.forcedSeason = s;
 
-    // record last-applied for controller (children will reuse controller snapshot)
-    LastApplied& snap = g_LastApplied[zoneId];
-    snap.state = state; snap.grade = normalizedGrade; snap.hasValue = true;
+    t.blendMinutes = ConfigOption<uint32>("WeatherVibe.DayPart.BlendMinutes", 0);
 
-    if (g_Debug)
+    t.starts.morning = ParseHHMM(ConfigText("WeatherVibe.DayPart.MORNING.Start", "06:00"), 6 * 60);
+    t.starts.afternoon = ParseHHMM(ConfigText("WeatherVibe.DayPart.AFTERNOON.Start", "12:00"), 12 * 60);
+    t.starts.evening = ParseHHMM(ConfigText("WeatherVibe.DayPart.EVENING.Start", "18:00"), 18 * 60);
+    t.starts.night = ParseHHMM(ConfigText("WeatherVibe.DayPart.NIGHT.Start", "22:00"), 22 * 60);
+
+    ValidateDayPartStarts(t.starts);
+}
+
+// "<min>, <max>" raw pair; falls back to def (and reports) on malformed values
+static Range ParseRangePair(std::string const& key, Range def)
+{
+    std::string_view v = ConfigText(key, "");
+    if (TrimView(v).empty())
+        return def;
+
+    std::string_view lo, hi;
+    float a = def.min, b = def.max;
+    if (!SplitPair(v, ',', lo, hi) || !ParseFloat(lo, a) || !ParseFloat(hi, b))
     {
-        Season s = GetCurrentSeason();
-        DayPart d = GetCurrentDayPart();
-        std::ostringstream zmsg;
-        zmsg << "|cff00ff00WeatherVibe:|r [DEBUG] season: " << SeasonName(s)
-            << " | day: " << DayPartName(d)
-            << " | state: " << WeatherStateName(state)
-            << " | grade: " << std::fixed << std::setprecision(2) << normalizedGrade
-            << " | zone: " << zoneId
-            << " | delivered: " << (delivered ? "true" : "false");
-        WorldSessionMgr::Instance()->SendZoneText(zoneId, zmsg.str().c_str());
-        if (itc != g_ZoneChildren.end())
-            for (uint32 child : itc->second)
-                WorldSessionMgr::Instance()->SendZoneText(child, zmsg.str().c_str());
+        ReportParseError(key, 0, v, "is not a '<min>, <max>' pair");
+        return def;
     }
 
-    return delivered;
+    if (b < a) std::swap(a, b);
+    return { std::clamp(a,0.0f,1.0f), std::clamp(b,0.0f,1.0f) };
 }
 
-// Re-send last-applied weather for a zone (login/zone-change helper)
-static void PushLastAppliedWeatherToClient(uint32 zoneIdRaw, Player* player)
+static void LoadStateRanges(ConfigTables& t)
 {
-    uint32 zoneId = ResolveControllerZone(zoneIdRaw);
-    auto it = g_LastApplied.find(zoneId);
-    if (it == g_LastApplied.end() || !it->second.hasValue)
-        return;
+    // one key buffer reused for all 48 keys: "<prefix><DAYPART>.<State>"
+    static constexpr std::string_view kPrefix = "WeatherVibe.Intensity.InternalRange.";
+    std::string key;
+    key.reserve(kPrefix.size() + 32);
+
+    Range def{ 0.30f, 1.00f }; // sensible defaults; expect config to reduce to ~0.65 tops
 
-    WorldPackets::Misc::Weather weatherPackage(it->second.state, it->second.grade);
-    player->SendDirectMessage(weatherPackage.Write());
+    for (DayPart dp : { DayPart::MORNING, DayPart::AFTERNOON, DayPart::EVENING, DayPart::NIGHT })
+        for (size_t i = 0; i < kStateCount; ++i)
+        {
+            key.assign(kPrefix).append(DayPartTokenUpper(dp)).append(1, '.').append(ConfigStateToken(kAcceptedStates[i]));
+            t.stateRanges[(size_t)dp][i] = ParseRangePair(key, def);
+        }
 }
 
-static void SeedAutoFromLastApplied(uint32 controllerZone, AutoZone& az)
+// Converts profile percent (0..1) to raw grade (per-WeatherState/daypart range)
+// `table` is one daypart row of g_StateRanges or the blended ActiveRanges() row.
+static float MapPercentToRawGrade(Range const* table, WeatherState state, float percent01)
 {
-    if (az.lastRawSent >= 0.0f) return; // already seeded
+    percent01 = std::clamp(percent01, 0.0f, 1.0f);
+    size_t idx = StateIndex(state);
+    Range r = (idx != kStateCount) ? table[idx] : Range{ 0.30f, 1.00f };
+
+    return r.min + percent01 * (r.max - r.min);
+}
+
+static float RawToPercent01(Range const* table, WeatherState state, float raw)
+{
+    size_t idx = StateIndex(state);
+    Range r = (idx != kStateCount) ? table[idx] : Range{ 0.0f, 1.0f };
+    if (r.max <= r.min) return 0.0f;
+    return std::clamp((raw - r.min) / (r.max - r.min), 0.0f, 1.0f);
+}
 
-    auto it = g_LastApplied.find(controllerZone);
-    if (it == g_LastApplied.end() || !it->second.hasValue) return;
+// ======================================
+// Visual quantization
+// ======================================
+// Builds the level tables from the loaded InternalRange bands (config or pack) and prebuilds a packet
+// per level. Levels: "WeatherVibe.Quantize.Levels" for all states, "...Levels.<State>" per state.
+static void LoadQuantization(ConfigTables& t)
+{
+    static constexpr std::string_view kKey = "WeatherVibe.Quantize.Levels";
+    t.quantizeLevels = ConfigOption<uint32>(std::string(kKey), 0);
 
-    DayPart dp = GetCurrentDayPart();
-    WeatherState st = it->second.state;
-    float raw = it->second.grade;
-    float pct = RawToPercent01(dp, st, raw) * 100.0f;
+    std::string key;
+    for (size_t i = 0; i < kStateCount; ++i)
+    {
+        WeatherState const state = kAcceptedStates[i];
+        key.assign(kKey).append(1, '.').append(ConfigStateToken(state));
+        uint32 levels = ConfigOption<uint32>(key, t.quantizeLevels);
+        if (levels > kMaxQuantLevels)
+        {
+            ReportParseError(key, 0, std::to_string(levels), "is above 255 levels (capped)");
+            levels = kMaxQuantLevels;
+        }
 
-    az.curState = st;  az.tgtState = st;
-    az.curPct = pct; az.tgtPct = pct;
-    az.tweenRemainMs = 0;
+        QuantTable& q = t.quant[i];
+        q = QuantTable{};
+        if (levels < 2)
+            continue;
 
-    az.lastRawSent = raw;
-    az.lastStateSent = st;
+        float lo = 1.0f, hi = 0.0f;
+        for (size_t dp = 0; dp < (size_t)DayPart::COUNT; ++dp)
+        {
+            lo = std::min(lo, t.stateRanges[dp][i].min);
+            hi = std::max(hi, t.stateRanges[dp][i].max);
+        }
+        q.lo = lo;
+        q.step = hi > lo ? (hi - lo) / float(levels - 1) : 0.0f;
+        for (uint32 l = 0; l < (q.step > 0.0f ? levels : 1); ++l)
+        {
+            q.grades.push_back(ClampToCoreBounds(lo + q.step * float(l), state));
+            WorldPackets::Misc::Weather weatherPackage(state, q.grades.back());
+            q.packets.push_back(*weatherPackage.Write());
+        }
+    }
+}
+
+static size_t QuantLevelOf(QuantTable const& q, float grade)
+{
+    if (q.step <= 0.0f)
+        return 0;
+    float level = std::round((grade - q.lo) / q.step);
+    return (size_t)std::clamp(level, 0.0f, float(q.grades.size() - 1));
+}
+
+// Snaps a grade to the nearest visual level of its state (unchanged when the state is not quantized).
+static float QuantizeGrade(WeatherState state, float grade)
+{
+    size_t idx = StateIndex(state);
+    if (idx == kStateCount || g_Quant[idx].grades.empty())
+        return grade;
+    return g_Quant[idx].grades[QuantLevelOf(g_Quant[idx], grade)];
+}
+
+// Prebuilt packet when the grade is exactly one of the state's levels, else nullptr.
+static WorldPacket const* QuantizedPacket(WeatherState state, float grade)
+{
+    size_t idx = StateIndex(state);
+    if (idx == kStateCount || g_Quant[idx].grades.empty())
+        return nullptr;
+    QuantTable const& q = g_Quant[idx];
+    size_t level = QuantLevelOf(q, grade);
+    return q.grades[level] == grade ? &q.packets[level] : nullptr;
+}
+
+// Grade the auto engine sends for a logical percent: band mapping, core bounds, then the visual level.
+static float AutoGradeFor(Range const* ranges, WeatherState state, float pct)
+{
+    return QuantizeGrade(state, ClampToCoreBounds(MapPercentToRawGrade(ranges, state, pct / 100.0f), state));
 }
 
 // ======================================
-// Auto engine helpers
+// Day/Season helpers (engine cell selection, debug/show)
 // ======================================
-static std::vector<std::string> SplitCSV(std::string s)
+static Season SeasonForYearDay(int yday);
+
+static Season GetCurrentSeason()
+{
+    if (g_ForcedSeason != Season::COUNT)
+        return g_ForcedSeason;
+
+    return SeasonForYearDay(GetLocalTimeSafe().tm_yday);
+}
+
+static Season SeasonForYearDay(int yday)
 {
-    std::vector<std::string> out;
-    std::string cur;
-    std::istringstream iss(s);
-    while (std::getline(iss, cur, ','))
+    if (g_ForcedSeason != Season::COUNT)
+        return g_ForcedSeason;
+
+    uint32 seasonIndex = ((yday - 78 + 365) / 91) % 4; // ~Mar 20 as 0
+
+    switch (seasonIndex)
     {
-        // trim
-        size_t a = cur.find_first_not_of(" \t\n\r");
-        size_t b = cur.find_last_not_of(" \t\n\r");
-        if (a == std::string::npos) continue;
-        out.emplace_back(cur.substr(a, b - a + 1));
+    default:
+    case 0: return Season::SPRING;
+    case 1: return Season::SUMMER;
+    case 2: return Season::AUTUMN;
+    case 3: return Season::WINTER;
     }
-    return out;
 }
 
-static std::string Lower(std::string s)
+static DayPart DayPartForMinute(DayPartStarts const& starts, int minutes)
 {
-    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return char(std::tolower(c)); });
-    return s;
+    if (minutes >= starts.night || minutes < starts.morning) return DayPart::NIGHT;
+    if (minutes >= starts.evening)   return DayPart::EVENING;
+    if (minutes >= starts.afternoon) return DayPart::AFTERNOON;
+    return DayPart::MORNING;
+}
+
+static DayPart DayPartForMinute(int minutes)
+{
+    return DayPartForMinute(g_Starts, minutes);
+}
+
+static int GetMinuteOfDay()
+{
+    tm lt = GetLocalTimeSafe();
+    return lt.tm_hour * 60 + lt.tm_min;
+}
+
+static DayPart DayPartAt(int minute)
+{
+    if (g_ForcedDayPart != DayPart::COUNT)
+        return g_ForcedDayPart;
+
+    return DayPartForMinute(minute);
+}
+
+static DayPart GetCurrentDayPart()
+{
+    return DayPartAt(GetMinuteOfDay());
 }
 
-static void LoadProfiles()
+// Precomputes (from, to, t) for every minute of the day. Each boundary gets a window of
+// BlendMinutes centred on its start time, capped to the shortest daypart so windows never overlap.
+static void BuildDayBlendTable(ConfigTables& t)
 {
-    g_Profiles.clear();
-    std::string names = sConfigMgr->GetOption<std::string>("WeatherVibe.Profile.Names", "Temperate");
-    for (auto name : SplitCSV(names))
+    int const starts[] = { t.starts.morning, t.starts.afternoon, t.starts.evening, t.starts.night };
+    int shortest = kMinutesPerDay;
+    for (size_t i = 0; i < 4; ++i)
+        shortest = std::min(shortest, (starts[(i + 1) % 4] - starts[i] + kMinutesPerDay) % kMinutesPerDay);
+    int const window = std::min<int>((int)t.blendMinutes, shortest);
+
+    for (int m = 0; m < kMinutesPerDay; ++m)
     {
-        Profile p; p.name = name;
-        std::string base = std::string("WeatherVibe.Profile.") + name + ".";
-        std::string w = sConfigMgr->GetOption<std::string>(base + "Weights", "");
-        if (!w.empty())
+        MinuteBlend& b = t.dayBlend[m];
+        b.from = b.to = DayPartForMinute(t.starts, m);
+        b.t = 0.0f;
+        if (window < 2)
+            continue;
+
+        for (size_t i = 0; i < 4; ++i)
         {
-            for (auto& kv : SplitCSV(w))
-            {
-                uint32 state = 0, weight = 0;
-                if (std::sscanf(kv.c_str(), " %u = %u ", &state, &weight) == 2)
-                {
-                    if (IsValidWeatherState(state) && weight > 0)
-                        p.weights[state] = weight;
-                }
-            }
+            // signed distance to this boundary, wrapped into [-720, 720)
+            int d = (m - starts[i] + kMinutesPerDay + kMinutesPerDay / 2) % kMinutesPerDay - kMinutesPerDay / 2;
+            if (d < -window / 2 || d >= window - window / 2)
+                continue;
+
+            b.from = DayPart((i + 3) % 4);
+            b.to = DayPart(i);
+            b.t = float(d + window / 2) / float(window);
+            break;
         }
-        p.pctMin = (float)sConfigMgr->GetOption<uint32>(base + "Percent.Min", 5u);
-        p.pctMax = (float)sConfigMgr->GetOption<uint32>(base + "Percent.Max", 55u);
-        if (p.pctMax < p.pctMin) std::swap(p.pctMax, p.pctMin);
-        g_Profiles[Lower(name)] = p;
     }
+}
 
-    // zone -> profile
-    g_ZoneProfile.clear();
-    std::string zpm = sConfigMgr->GetOption<std::string>("WeatherVibe.ZoneProfile.Map", "");
-    for (auto& kv : SplitCSV(zpm))
-    {
-        uint32 zone = 0; char prof[128] = { 0 };
-        if (std::sscanf(kv.c_str(), " %u = %127s ", &zone, prof) == 2 && zone)
-            g_ZoneProfile[zone] = Lower(prof);
-    }
+// Cache key for the ranges at a minute of day: the minute itself, or one key per forced daypart.
+static int RangesKeyAt(ConfigTables const& t, int minute)
+{
+    return (t.forcedDayPart != DayPart::COUNT) ? kMinutesPerDay + (int)t.forcedDayPart : minute;
 }
 
-static void LoadAutoConfig()
+static int RangesKeyAt(int minute)
 {
-    g_AutoEnabled = sConfigMgr->GetOption<uint32>("WeatherVibe.Auto.Enable", 0) != 0;
-    g_AutoTickMs = sConfigMgr->GetOption<uint32>("WeatherVibe.Auto.TickMs", 1000);
-    g_MinWindowSec = sConfigMgr->GetOption<uint32>("WeatherVibe.Auto.MinWindowSec", 180);
-    g_MaxWindowSec = sConfigMgr->GetOption<uint32>("WeatherVibe.Auto.MaxWindowSec", 480);
-    g_TweenSec = sConfigMgr->GetOption<uint32>("WeatherVibe.Auto.TweenSec", 20);
-    g_TinyNudge = sConfigMgr->GetOption<float>("WeatherVibe.Auto.TinyNudge", 0.01f);
+    return RangesKeyAt(g_Tables, minute);
 }
 
-static WeatherState PickStateFromWeights(Profile const& p)
+static void BlendRangesForKey(ConfigTables const& t, int key, Range* out)
 {
-    // Build discrete distribution
-    std::vector<uint32> states; states.reserve(p.weights.size());
-    std::vector<double> weights; weights.reserve(p.weights.size());
-    for (auto const& kv : p.weights)
+    MinuteBlend b = (t.forcedDayPart != DayPart::COUNT) ? MinuteBlend{ t.forcedDayPart, t.forcedDayPart, 0.0f } : t.dayBlend[key];
+    Range const* from = t.stateRanges[(size_t)b.from];
+    Range const* to = t.stateRanges[(size_t)b.to];
+    for (size_t i = 0; i < kStateCount; ++i)
     {
-        states.push_back(kv.first);
-        weights.push_back((double)kv.second);
+        out[i].min = from[i].min + (to[i].min - from[i].min) * b.t;
+        out[i].max = from[i].max + (to[i].max - from[i].max) * b.t;
     }
-    if (states.empty())
-        return WEATHER_STATE_FINE;
+}
 
-    std::discrete_distribution<size_t> dist(weights.begin(), weights.end());
-    return static_cast<WeatherState>(states[dist(g_Rng)]);
+static void BlendRangesForKey(int key, Range* out)
+{
+    BlendRangesForKey(g_Tables, key, out);
 }
 
-static float RandPercentBetween(Profile const& p)
+// Ranges in effect now. Blended once per minute (or per forced daypart) and cached; callers index it by state.
+static Range const* ActiveRanges()
 {
-    if (p.pctMax <= p.pctMin) return p.pctMin;
-    std::uniform_real_distribution<float> d(p.pctMin, p.pctMax);
-    return d(g_Rng);
+    int key = RangesKeyAt(GetMinuteOfDay());
+    if (key == g_ActiveRangesKey)
+        return g_ActiveRanges;
+
+    BlendRangesForKey(key, g_ActiveRanges);
+    g_ActiveRangesKey = key;
+    return g_ActiveRanges;
 }
 
-static uint32 RandWindowMs()
+// ======================================
+// Zone parent mapping
+// ======================================
+static uint32 ResolveControllerZone(ConfigTables const& t, uint32 zoneId)
 {
-    if (g_MaxWindowSec < g_MinWindowSec) std::swap(g_MaxWindowSec, g_MinWindowSec);
-    std::uniform_int_distribution<uint32> d(g_MinWindowSec, g_MaxWindowSec);
-    return d(g_Rng) * 1000u;
+    auto it = t.zoneParent.find(zoneId);
+    if (it == t.zoneParent.end()) return zoneId;
+    // chain-safe (in case of multi-level mapping)
+    uint32 cur = zoneId;
+    std::unordered_set<uint32> seen;
+    while ((it = t.zoneParent.find(cur)) != t.zoneParent.end())
+    {
+        if (!seen.insert(cur).second) break; // cycle guard
+        cur = it->second;
+    }
+    return cur;
 }
 
-static void EnsureAutoZone(uint32 controllerZone)
+static uint32 ResolveControllerZone(uint32 zoneId)
 {
-    if (g_AutoZones.count(controllerZone)) return;
-    AutoZone az; az.enabled = false; // default off until mapped
-    g_AutoZones[controllerZone] = az;
+    return ResolveControllerZone(g_Tables, zoneId);
 }
 
-static void InitializeAutoZonesFromConfig()
+// ======================================
+// Push sink: where weather packets go
+// ======================================
+// A player as the sink hands it out; player is null for synthetic rosters (guid only).
+struct WeatherRecipient
+{
+    ObjectGuid guid;
+    Player* player = nullptr;
+};
+
+// Everything the engine delivers goes through g_Sink: the world session manager in production, a
+// recorder (synthetic roster + counters) for load tests.
+class WeatherSink
+{
+public:
+    virtual ~WeatherSink() = default;
+
+    virtual bool SendToZone(uint32 zoneId, WorldPacket const* packet) = 0;
+    virtual bool SendToPlayer(WeatherRecipient const& to, WorldPacket const* packet) = 0;
+    virtual void SendZoneText(uint32 zoneId, char const* text) = 0;
+    virtual void ForEachInZone(uint32 zoneId, std::function<void(WeatherRecipient const&)> const& visit) = 0;
+};
+
+class WorldSessionSink final : public WeatherSink
 {
-    g_AutoZones.clear();
-    for (auto const& zprof : g_ZoneProfile)
+public:
+    bool SendToZone(uint32 zoneId, WorldPacket const* packet) override
     {
-        uint32 controller = ResolveControllerZone(zprof.first);
-        EnsureAutoZone(controller);
-        AutoZone& az = g_AutoZones[controller];
-        az.enabled = true; // controlled because profile exists
-        az.profile = zprof.second; // lowercased name
-        az.curState = WEATHER_STATE_FINE;
-        az.curPct = 0.0f;
-        az.tgtState = WEATHER_STATE_FINE;
-        az.tgtPct = 0.0f;
-        az.windowRemainMs = 0;
-        az.tweenRemainMs = 0;
-        az.lastRawSent = -1.0f;
-        az.lastStateSent = WEATHER_STATE_FINE;
-        az.sprinkle = Sprinkle{};
-        SeedAutoFromLastApplied(controller, az);
+        return sWorldSessionMgr->SendZoneMessage(zoneId, packet);
     }
-}
 
-static void SyncAutoWithManual(uint32 zoneIdRaw, WeatherState state, float rawGrade)
-{
-    if (!g_AutoEnabled) return;
+    bool SendToPlayer(WeatherRecipient const& to, WorldPacket const* packet) override
+    {
+        Player* player = to.player ? to.player : ObjectAccessor::FindPlayer(to.guid);
+        if (!player || !player->IsInWorld())
+            return false;
+        player->SendDirectMessage(packet);
+        return true;
+    }
 
-    uint32 controller = ResolveControllerZone(zoneIdRaw);
-    auto it = g_AutoZones.find(controller);
-    if (it == g_AutoZones.end() || !it->second.enabled) return;
+    void SendZoneText(uint32 zoneId, char const* text) override
+    {
+        sWorldSessionMgr->SendZoneText(zoneId, text);
+    }
 
-    AutoZone& az = it->second;
-    DayPart dp = GetCurrentDayPart();
-    float pct = RawToPercent01(dp, state, rawGrade) * 100.0f;
+    void ForEachInZone(uint32 zoneId, std::function<void(WeatherRecipient const&)> const& visit) override
+    {
+        for (auto const& [accountId, session] : sWorldSessionMgr->GetAllSessions())
+        {
+            Player* player = session ? session->GetPlayer() : nullptr;
+            if (player && player->IsInWorld() && player->GetZoneId() == zoneId)
+                visit(WeatherRecipient{ player->GetGUID(), player });
+        }
+    }
+};
 
-    az.curState = state; az.tgtState = state;
-    az.curPct = pct;   az.tgtPct = pct;
-    az.tweenRemainMs = 0;
+// Load-test sink: players exist only as (guid, zone) rows; counts what production would have sent.
+class RecordingSink final : public WeatherSink
+{
+public:
+    struct Counters
+    {
+        uint64 packets = 0;     // send calls (one zone broadcast = one)
+        uint64 recipients = 0;  // packet copies that reach a player
+        uint64 bytes = 0;       // payload bytes over all recipients
+    };
 
-    if (az.windowRemainMs == 0) az.windowRemainMs = RandWindowMs();
+    void Join(ObjectGuid guid, uint32 zoneId)
+    {
+        _zoneOf[guid.GetCounter()] = zoneId;
+        _roster[zoneId].push_back(guid);
+    }
 
-    az.lastRawSent = ClampToCoreBounds(rawGrade, state);
-    az.lastStateSent = state;
+    bool SendToZone(uint32 zoneId, WorldPacket const* packet) override
+    {
+        auto it = _roster.find(zoneId);
+        size_t n = it == _roster.end() ? 0 : it->second.size();
+        Count(zoneId, n, packet);
+        return n != 0;
+    }
+
+    bool SendToPlayer(WeatherRecipient const& to, WorldPacket const* packet) override
+    {
+        auto it = _zoneOf.find(to.guid.GetCounter());
+        if (it == _zoneOf.end())
+            return false;
+        Count(it->second, 1, packet);
+        return true;
+    }
+
+    void SendZoneText(uint32 /*zoneId*/, char const* /*text*/) override {}
+
+    void ForEachInZone(uint32 zoneId, std::function<void(WeatherRecipient const&)> const& visit) override
+    {
+        auto it = _roster.find(zoneId);
+        if (it != _roster.end())
+            for (ObjectGuid guid : it->second)
+                visit(WeatherRecipient{ guid, nullptr });
+    }
+
+    Counters const& Total() const { return _total; }
+    std::unordered_map<uint32, Counters> const& PerZone() const { return _perZone; }
+    void ResetCounters() { _total = Counters{}; _perZone.clear(); }
+
+private:
+    void Count(uint32 zoneId, size_t recipients, WorldPacket const* packet)
+    {
+        for (Counters* c : { &_total, &_perZone[zoneId] })
+        {
+            ++c->packets;
+            c->recipients += recipients;
+            c->bytes += recipients * packet->size();
+        }
+    }
+
+    std::unordered_map<uint32, std::vector<ObjectGuid>> _roster; // zone -> players
+    std::unordered_map<uint32, uint32> _zoneOf;                 // guid low -> zone
+    Counters _total;
+    std::unordered_map<uint32, Counters> _perZone;
+};
+
+namespace
+{
+    WorldSessionSink g_WorldSink;
+    WeatherSink* g_Sink = &g_WorldSink;
+}
+
+// ======================================
+// Area (sub-zone) controllers
+// ======================================
+static uint16 AreaSlotOf(uint32 areaId)
+{
+    return areaId < g_AreaSlot.size() ? g_AreaSlot[areaId] : 0;
+}
+
+// Moves a player between controlled areas (slot 0 = none). Returns true when the player's weather
+// source (area or zone) changed, i.e. when they need a packet. Hash lookups only, no scans.
+static bool MovePlayerArea(ObjectGuid guid, uint32 zoneId, uint32 areaId)
+{
+    uint16 slot = AreaSlotOf(areaId);
+    if (slot >= g_AreaPlayers.size() || g_AreaControllers[slot].zone != zoneId)
+        slot = 0; // area id of the previous zone during a zone switch
+
+    auto it = g_PlayerAreaSeat.find(guid.GetCounter());
+    if (it == g_PlayerAreaSeat.end())
+    {
+        if (!slot)
+            return false;
+        it = g_PlayerAreaSeat.emplace(guid.GetCounter(), AreaSeat{}).first;
+    }
+
+    AreaSeat& seat = it->second;
+    if (seat.slot == slot)
+        return false;
+
+    if (seat.slot)
+    {
+        std::vector<ObjectGuid>& members = g_AreaPlayers[seat.slot];
+        ObjectGuid const moved = members.back();
+        members[seat.index] = moved;
+        members.pop_back();
+        if (!(moved == guid))
+            g_PlayerAreaSeat[moved.GetCounter()].index = seat.index;
+        --g_AreaOccupiedPerZone[g_AreaControllers[seat.slot].zone];
+    }
+    seat.slot = slot;
+    if (slot)
+    {
+        seat.index = (uint32)g_AreaPlayers[slot].size();
+        g_AreaPlayers[slot].push_back(guid);
+        ++g_AreaOccupiedPerZone[g_AreaControllers[slot].zone];
+    }
+    return true;
+}
+
+static void ForgetPlayerArea(ObjectGuid guid)
+{
+    MovePlayerArea(guid, 0, 0);
+    g_PlayerAreaSeat.erase(guid.GetCounter());
+}
+
+static uint16 PlayerAreaSlot(uint32 guidLow)
+{
+    auto it = g_PlayerAreaSeat.find(guidLow);
+    return it == g_PlayerAreaSeat.end() ? 0 : it->second.slot;
+}
+
+// Resizes occupancy to the loaded area table and re-files the online players (startup/reload).
+static void RebuildAreaOccupancy()
+{
+    g_AreaPlayers.assign(g_AreaControllers.size(), {});
+    g_PlayerAreaSeat.clear();
+    g_AreaOccupiedPerZone.clear();
+    if (g_AreaControllers.size() <= 1)
+        return;
+
+    for (auto const& [accountId, session] : sWorldSessionMgr->GetAllSessions())
+        if (Player* player = session ? session->GetPlayer() : nullptr)
+            if (player->IsInWorld())
+                MovePlayerArea(player->GetGUID(), player->GetZoneId(), player->GetAreaId());
+}
+
+// Controller whose weather the player sees: their controlled area, else their zone's controller.
+static uint32 PlayerWeatherController(uint32 guidLow, uint32 zoneId)
+{
+    uint16 slot = PlayerAreaSlot(guidLow);
+    return slot ? g_AreaControllers[slot].area : ResolveControllerZone(zoneId);
+}
+
+// ======================================
+// Player personalization
+// ======================================
+// Settings persist per character in weathervibe_player_prefs (data/sql/db-characters/base); only
+// non-default settings have a row. Read once at startup, written through on every change.
+static void LoadPlayerPrefs()
+{
+    g_PlayerPrefs.clear();
+    QueryResult result = CharacterDatabase.Query("SELECT guid, max_pct, blocked FROM weathervibe_player_prefs");
+    if (!result)
+        return;
+
+    do
+    {
+        Field* fields = result->Fetch();
+        PlayerPrefs prefs;
+        prefs.maxPct = std::min<uint8>(fields[1].Get<uint8>(), 100);
+        prefs.blocked = fields[2].Get<uint16>() & uint16((1u << kStateCount) - 1);
+        if (!prefs.IsDefault())
+            g_PlayerPrefs[fields[0].Get<uint32>()] = prefs;
+    } while (result->NextRow());
+
+    LOG_INFO("server.loading", "[WeatherVibe] loaded {} personal weather settings", g_PlayerPrefs.size());
+}
+
+static void SavePlayerPrefs(uint32 guidLow, PlayerPrefs const& prefs)
+{
+    if (prefs.IsDefault())
+        CharacterDatabase.Execute("DELETE FROM weathervibe_player_prefs WHERE guid = {}", guidLow);
+    else
+        CharacterDatabase.Execute("REPLACE INTO weathervibe_player_prefs (guid, max_pct, blocked) VALUES ({}, {}, {})",
+            guidLow, uint32(prefs.maxPct), uint32(prefs.blocked));
+}
+
+static PlayerPrefs const* FindPlayerPrefs(uint32 guidLow)
+{
+    if (!g_PersonalEnabled)
+        return nullptr;
+    auto it = g_PlayerPrefs.find(guidLow);
+    return it == g_PlayerPrefs.end() ? nullptr : &it->second;
+}
+
+// What a player with these settings sees instead of (state, grade).
+static void ApplyPlayerPrefs(PlayerPrefs const& prefs, WeatherState& state, float& grade)
+{
+    size_t idx = StateIndex(state);
+    if (idx != kStateCount && ((prefs.blocked >> idx) & 1u))
+    {
+        state = WEATHER_STATE_FINE;
+        grade = 0.0f;
+    }
+    grade = ClampToCoreBounds(std::min(grade, prefs.maxPct / 100.0f), state);
+}
+
+static void UntrackPersonalizedPlayer(uint32 guidLow)
+{
+    auto it = g_PersonalizedOnline.find(guidLow);
+    if (it == g_PersonalizedOnline.end())
+        return;
+    auto zc = g_PersonalizedPerZone.find(it->second);
+    if (zc != g_PersonalizedPerZone.end() && --zc->second == 0)
+        g_PersonalizedPerZone.erase(zc);
+    g_PersonalizedOnline.erase(it);
+}
+
+// Keeps the per-zone count of online personalized players current (login, zone change, prefs change).
+static void TrackPersonalizedPlayer(uint32 guidLow, uint32 zoneId)
+{
+    UntrackPersonalizedPlayer(guidLow);
+    if (!g_PlayerPrefs.count(guidLow))
+        return;
+    g_PersonalizedOnline[guidLow] = zoneId;
+    ++g_PersonalizedPerZone[zoneId];
+}
+
+// Packets for one delivery: the shared broadcast plus one per distinct result, built on first use.
+// Players are grouped by settings key; keys that end up showing the same weather share a packet.
+struct PersonalPackets
+{
+    struct Group { uint32 key; WeatherState state; float grade; WorldPacket const* packet; };
+
+    WeatherState state;
+    float grade;
+    WorldPacket const* shared;
+    std::vector<Group> groups;
+    std::deque<WorldPackets::Misc::Weather> built;
+
+    WorldPacket const* For(PlayerPrefs const& prefs)
+    {
+        uint32 key = prefs.Key();
+        for (Group const& g : groups)
+            if (g.key == key)
+                return g.packet;
+
+        Group group{ key, state, grade, shared };
+        ApplyPlayerPrefs(prefs, group.state, group.grade);
+        if (group.state != state || group.grade != grade) // settings that change nothing here reuse the broadcast
+        {
+            auto same = std::find_if(groups.begin(), groups.end(), [&](Group const& g) { return g.state == group.state && g.grade == group.grade; });
+            if (same != groups.end())
+                group.packet = same->packet;
+            else if (!(group.packet = QuantizedPacket(group.state, group.grade)))
+                group.packet = built.emplace_back(group.state, group.grade).Write();
+        }
+        groups.push_back(group);
+        return group.packet;
+    }
+};
+
+// Area controllers only reach the players tracked inside them.
+static bool SendAreaWeather(uint16 slot, PersonalPackets& packets)
+{
+    bool delivered = false;
+    for (ObjectGuid guid : g_AreaPlayers[slot])
+    {
+        PlayerPrefs const* prefs = FindPlayerPrefs(guid.GetCounter());
+        delivered = g_Sink->SendToPlayer(WeatherRecipient{ guid, nullptr }, prefs ? packets.For(*prefs) : packets.shared) || delivered;
+    }
+    return delivered;
+}
+
+// SendZoneMessage, unless the zone holds personalized players or players inside controlled areas: then
+// one pass over the sessions (what SendZoneMessage does anyway) hands each player the packet of its
+// settings group and skips those the area controls.
+static bool SendZoneWeather(uint32 zoneId, PersonalPackets& packets)
+{
+    if (uint16 slot = AreaSlotOf(zoneId); slot && slot < g_AreaPlayers.size())
+        return SendAreaWeather(slot, packets);
+
+    bool const personal = g_PersonalEnabled && g_PersonalizedPerZone.count(zoneId);
+    auto occupied = g_AreaOccupiedPerZone.find(zoneId);
+    bool const areas = occupied != g_AreaOccupiedPerZone.end() && occupied->second;
+    if (!personal && !areas)
+        return g_Sink->SendToZone(zoneId, packets.shared);
+
+    bool delivered = false;
+    g_Sink->ForEachInZone(zoneId, [&](WeatherRecipient const& to)
+    {
+        uint32 guidLow = to.guid.GetCounter();
+        if (areas && PlayerAreaSlot(guidLow))
+            return;
+        PlayerPrefs const* prefs = FindPlayerPrefs(guidLow);
+        delivered = g_Sink->SendToPlayer(to, prefs ? packets.For(*prefs) : packets.shared) || delivered;
+    });
+    return delivered;
+}
+
+// ======================================
+// Applies weather to a zone (returns true only when actually delivered to at least one player).
+// ======================================
+// Sends a built packet to a controller zone and its children and records last-applied.
+static bool DeliverToController(uint32 zoneId, PersonalPackets& packets)
+{
+    WeatherState const state = packets.state;
+    float const normalizedGrade = packets.grade;
+
+    // We send to controller and children
+    bool delivered = SendZoneWeather(zoneId, packets);
+    auto itc = g_ZoneChildren.find(zoneId);
+    if (itc != g_ZoneChildren.end())
+        for (uint32 child : itc->second)
+            delivered = SendZoneWeather(child, packets) || delivered;
+
+    // record last-applied for controller (children will reuse controller snapshot)
+    g_LastApplied.Set(zoneId, state, normalizedGrade);
+
+    if (g_Debug)
+    {
+        Season s = GetCurrentSeason();
+        DayPart d = GetCurrentDayPart();
+        std::ostringstream zmsg;
+        zmsg << "|cff00ff00WeatherVibe:|r [DEBUG] season: " << SeasonName(s)
+            << " | day: " << DayPartName(d)
+            << " | state: " << WeatherStateName(state)
+            << " | grade: " << std::fixed << std::setprecision(2) << normalizedGrade
+            << " | zone: " << zoneId
+            << " | delivered: " << (delivered ? "true" : "false");
+        g_Sink->SendZoneText(zoneId, zmsg.str().c_str());
+        if (itc != g_ZoneChildren.end())
+            for (uint32 child : itc->second)
+                g_Sink->SendZoneText(child, zmsg.str().c_str());
+    }
+
+    return delivered;
+}
+
+// A push's packets: the prebuilt packet of a quantized level when the grade is one, else a fresh build.
+static PersonalPackets MakePushPackets(WeatherState state, float normalizedGrade)
+{
+    PersonalPackets packets{ state, normalizedGrade, QuantizedPacket(state, normalizedGrade), {}, {} };
+    if (!packets.shared)
+        packets.shared = packets.built.emplace_back(state, normalizedGrade).Write();
+    return packets;
+}
+
+static bool PushWeatherToClient(uint32 zoneIdRaw, WeatherState state, float rawGrade)
+{
+    PersonalPackets packets = MakePushPackets(state, ClampToCoreBounds(rawGrade, state));
+    return DeliverToController(ResolveControllerZone(zoneIdRaw), packets);
+}
+
+// Same weather for many controllers: one packet, one fan-out per controller. Returns zones delivered to.
+static uint32 PushWeatherBatch(std::vector<uint32> const& controllers, WeatherState state, float rawGrade)
+{
+    PersonalPackets packets = MakePushPackets(state, ClampToCoreBounds(rawGrade, state));
+
+    uint32 delivered = 0;
+    for (uint32 controller : controllers)
+        delivered += DeliverToController(controller, packets) ? 1 : 0;
+    return delivered;
+}
+
+// Re-send the last-applied weather of the player's area or zone (login/zone-change/area-change helper).
+// clearIfUnset: nothing recorded there yet -> send clear skies instead of leaving the old weather up.
+static void PushLastAppliedWeatherToClient(WeatherRecipient const& to, uint32 zoneId, bool clearIfUnset = false)
+{
+    uint32 const guidLow = to.guid.GetCounter();
+    LastApplied const* snap = g_LastApplied.Find(PlayerWeatherController(guidLow, zoneId));
+    if (!snap && !clearIfUnset)
+        return;
+
+    WeatherState state = snap ? snap->State() : WEATHER_STATE_FINE;
+    float grade = snap ? snap->Grade() : 0.0f;
+    if (PlayerPrefs const* prefs = FindPlayerPrefs(guidLow))
+        ApplyPlayerPrefs(*prefs, state, grade);
+    WorldPackets::Misc::Weather weatherPackage(state, grade);
+    g_Sink->SendToPlayer(to, weatherPackage.Write());
+}
+
+// Reads a copy of the store and ranges when a reload is built off the world thread.
+static void SeedAutoFromLastApplied(LastAppliedStore const& lastApplied, Range const* ranges, uint32 controllerZone, AutoZone& az)
+{
+    if (az.lastRawSent >= 0.0f) return; // already seeded
+
+    LastApplied const* snap = lastApplied.Find(controllerZone);
+    if (!snap) return;
+
+    WeatherState st = snap->State();
+    float raw = snap->Grade();
+    float pct = RawToPercent01(ranges, st, raw) * 100.0f;
+
+    az.curState = st;  az.tgtState = st;
+    az.curPct = pct; az.tgtPct = pct;
+    az.tweenMs = 0;
+
+    az.lastRawSent = raw;
+    az.lastStateSent = st;
+}
+
+static void SeedAutoFromLastApplied(uint32 controllerZone, AutoZone& az)
+{
+    SeedAutoFromLastApplied(g_LastApplied, ActiveRanges(), controllerZone, az);
+}
+
+// ======================================
+// Player events (hooks and synthetic rosters share these)
+// ======================================
+static void SeedPlayerController(uint32 guidLow, uint32 zoneId)
+{
+    uint32 controller = PlayerWeatherController(guidLow, zoneId);
+    if (auto it = g_AutoZones.find(controller); it != g_AutoZones.end() && it->second.enabled)
+    {
+        SeedAutoFromLastApplied(controller, it->second);
+    }
+}
+
+// Login and zone change: re-file the player and show the weather of where they now are.
+static void PlayerArrived(WeatherRecipient const& who, uint32 zoneId, uint32 areaId)
+{
+    uint32 guidLow = who.guid.GetCounter();
+    TrackPersonalizedPlayer(guidLow, zoneId);
+    MovePlayerArea(who.guid, zoneId, areaId);
+    SeedPlayerController(guidLow, zoneId);
+    PushLastAppliedWeatherToClient(who, zoneId);
+}
+
+// Area moves inside a zone only matter when they enter or leave a controlled area.
+static void PlayerChangedArea(WeatherRecipient const& who, uint32 zoneId, uint32 areaId)
+{
+    if (g_AreaControllers.size() <= 1 || !MovePlayerArea(who.guid, zoneId, areaId))
+        return;
+    SeedPlayerController(who.guid.GetCounter(), zoneId);
+    PushLastAppliedWeatherToClient(who, zoneId, true);
+}
+
+static void PlayerLeft(ObjectGuid guid)
+{
+    UntrackPersonalizedPlayer(guid.GetCounter());
+    ForgetPlayerArea(guid);
+}
+
+// ======================================
+// Auto engine helpers
+// ======================================
+// Builds the alias table for a dense weight row (Vose's method).
+static void BuildSampler(std::array<uint32, kStateCount> const& weights, StateSampler& out)
+{
+    out = StateSampler{};
+
+    uint64 total = 0;
+    for (uint32 w : weights) total += w;
+    if (!total)
+        return;
+
+    std::array<double, kStateCount> scaled{};
+    std::array<uint8, kStateCount> small{}, large{};
+    size_t ns = 0, nl = 0;
+    for (size_t i = 0; i < kStateCount; ++i)
+    {
+        scaled[i] = (double)weights[i] * kStateCount / (double)total;
+        out.alias[i] = (uint8)i;
+        if (scaled[i] < 1.0) small[ns++] = (uint8)i; else large[nl++] = (uint8)i;
+    }
+
+    while (ns && nl)
+    {
+        uint8 s = small[--ns], l = large[--nl];
+        out.prob[s] = (float)scaled[s];
+        out.alias[s] = l;
+        scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+        if (scaled[l] < 1.0) small[ns++] = l; else large[nl++] = l;
+    }
+    while (nl) out.prob[large[--nl]] = 1.0f;
+    while (ns) out.prob[small[--ns]] = 1.0f; // rounding leftovers
+
+    out.empty = false;
+}
+
+static WeatherState SampleState(StateSampler const& s)
+{
+    if (s.empty)
+        return WEATHER_STATE_FINE;
+
+    std::uniform_int_distribution<size_t> column(0, kStateCount - 1);
+    std::uniform_real_distribution<float> coin(0.0f, 1.0f);
+    size_t i = column(g_Rng);
+    return kAcceptedStates[coin(g_Rng) < s.prob[i] ? i : s.alias[i]];
+}
+
+// "<state>=<weight>,..." -> weights indexed by dense state index
+static void ParseWeights(std::string const& key, std::string_view value, std::array<uint32, kStateCount>& out)
+{
+    ForEachToken(value, ',', [&](std::string_view tok, size_t index)
+    {
+        std::string_view lhs, rhs;
+        uint32 state = 0, weight = 0;
+        if (!SplitPair(tok, '=', lhs, rhs) || !ParseUInt(lhs, state) || !ParseUInt(rhs, weight))
+        {
+            ReportParseError(key, index, tok, "is not '<state>=<weight>'");
+            return;
+        }
+
+        size_t idx = StateIndex(state);
+        if (idx == kStateCount)
+        {
+            ReportParseError(key, index, tok, "uses an unsupported state id");
+            return;
+        }
+
+        out[idx] = weight;
+    });
+}
+
+// Reads "<key prefix>Weights" and "<key prefix>Percent.Min/Max" into a layer; key[0, baseLen) is the prefix.
+static void ParseLayerKeys(std::string& key, size_t baseLen, ProfileLayer& out)
+{
+    key.resize(baseLen); key.append("Weights");
+    std::string_view weights = ConfigText(key, "");
+    ForEachToken(weights, ',', [&](std::string_view tok, size_t index)
+    {
+        std::string_view lhs, rhs;
+        uint32 state = 0;
+        size_t idx = kStateCount;
+        if (!SplitPair(tok, '=', lhs, rhs) || !ParseUInt(lhs, state) || (idx = StateIndex(state)) == kStateCount
+            || !ParseLayerEdit(rhs, out.weights[idx]))
+            ReportParseError(key, index, tok, "is not '<state>=<weight|+delta|-delta>'");
+    });
+
+    for (auto [field, edit] : { std::pair{ "Percent.Min", &out.pctMin }, std::pair{ "Percent.Max", &out.pctMax } })
+    {
+        key.resize(baseLen); key.append(field);
+        std::string_view v = ConfigText(key, "");
+        if (!TrimView(v).empty() && !ParseLayerEdit(v, *edit))
+            ReportParseError(key, 0, v, "is not '<percent|+delta|-delta>'");
+    }
+}
+
+// Applies a layer's edits to a cell (weights floor at 0, percents clamp to 0..100). Sampler is not rebuilt.
+static void ApplyLayer(ProfileLayer const& layer, ProfileCell& cell)
+{
+    for (size_t i = 0; i < kStateCount; ++i)
+        cell.weights[i] = (uint32)std::max<int32>(0, layer.weights[i].Apply((int32)cell.weights[i]));
+    cell.pctMin = std::clamp(layer.pctMin.Apply(cell.pctMin), 0.0f, 100.0f);
+    cell.pctMax = std::clamp(layer.pctMax.Apply(cell.pctMax), 0.0f, 100.0f);
+    if (cell.pctMax < cell.pctMin) std::swap(cell.pctMax, cell.pctMin);
+}
+
+static void LoadProfiles(ConfigTables& t)
+{
+    t.profiles.clear();
+
+    // one key buffer reused for every profile key: "WeatherVibe.Profile.<Name>.<Field>"
+    std::string key;
+    std::string lowered;
+
+    std::string_view names = ConfigText("WeatherVibe.Profile.Names", "Temperate");
+    ForEachToken(names, ',', [&](std::string_view name, size_t /*index*/)
+    {
+        key.assign("WeatherVibe.Profile.").append(name).append(1, '.');
+        size_t const baseLen = key.size();
+
+        AssignLower(lowered, name);
+        auto& slot = t.profiles[lowered];
+        slot = std::make_shared<Profile>();
+        Profile& p = *slot;
+        p.name.assign(name);
+
+        ProfileCell base;
+        key.resize(baseLen); key.append("Weights");
+        ParseWeights(key, ConfigText(key, ""), base.weights);
+
+        key.resize(baseLen); key.append("Percent.Min");
+        base.pctMin = (float)ConfigOption<uint32>(key, 5u);
+        key.resize(baseLen); key.append("Percent.Max");
+        base.pctMax = (float)ConfigOption<uint32>(key, 55u);
+        if (base.pctMax < base.pctMin) std::swap(base.pctMax, base.pctMin);
+
+        // optional layers: "<Name>.<SEASON>.*" and "<Name>.<DAYPART>.*" (daypart applies after season)
+        std::array<ProfileLayer, (size_t)Season::COUNT> seasons{};
+        std::array<ProfileLayer, (size_t)DayPart::COUNT> dayParts{};
+        for (size_t si = 0; si < seasons.size(); ++si)
+        {
+            key.resize(baseLen); key.append(SeasonTokenUpper(Season(si))).append(1, '.');
+            ParseLayerKeys(key, key.size(), seasons[si]);
+        }
+        for (size_t di = 0; di < dayParts.size(); ++di)
+        {
+            key.resize(baseLen); key.append(DayPartTokenUpper(DayPart(di))).append(1, '.');
+            ParseLayerKeys(key, key.size(), dayParts[di]);
+        }
+
+        for (size_t si = 0; si < seasons.size(); ++si)
+            for (size_t di = 0; di < dayParts.size(); ++di)
+            {
+                ProfileCell& cell = p.cells[CellIndex(Season(si), DayPart(di))];
+                cell = base;
+                ApplyLayer(seasons[si], cell);
+                ApplyLayer(dayParts[di], cell);
+                BuildSampler(cell.weights, cell.sampler);
+            }
+    });
+
+    // zone -> profile
+    t.zoneProfile.clear();
+    static std::string const kZoneMapKey = "WeatherVibe.ZoneProfile.Map";
+    std::string_view zpm = ConfigText(kZoneMapKey, "");
+    ForEachToken(zpm, ',', [&](std::string_view tok, size_t index)
+    {
+        std::string_view lhs, rhs;
+        uint32 zone = 0;
+        if (!SplitPair(tok, '=', lhs, rhs) || !ParseUInt(lhs, zone) || !zone)
+        {
+            ReportParseError(kZoneMapKey, index, tok, "is not '<zoneId>=<profile>'");
+            return;
+        }
+
+        std::string& prof = t.zoneProfile[zone];
+        AssignLower(prof, rhs);
+        if (!t.profiles.count(prof))
+            ReportParseError(kZoneMapKey, index, tok, "references an unknown profile (falls back at runtime)");
+    });
+}
+
+// "<childZone>=<parentZone>,..." -> g_ZoneParent + reverse g_ZoneChildren
+static void LoadZoneParents(ConfigTables& t)
+{
+    t.zoneParent.clear();
+    t.zoneChildren.clear();
+
+    static std::string const kParentKey = "WeatherVibe.ZoneParent.Map";
+    std::string_view zpm = ConfigText(kParentKey, "");
+    ForEachToken(zpm, ',', [&](std::string_view tok, size_t index)
+    {
+        std::string_view lhs, rhs;
+        uint32 child = 0, parent = 0;
+        if (!SplitPair(tok, '=', lhs, rhs) || !ParseUInt(lhs, child) || !ParseUInt(rhs, parent) || !child || !parent)
+        {
+            ReportParseError(kParentKey, index, tok, "is not '<childZone>=<parentZone>'");
+            return;
+        }
+        if (child == parent || t.zoneParent.count(child))
+        {
+            ReportParseError(kParentKey, index, tok, "is self-referencing or a duplicate child");
+            return;
+        }
+
+        t.zoneParent[child] = parent;
+        t.zoneChildren[parent].push_back(child);
+    });
+}
+
+// WeatherVibe.ZoneOverride.Zones = <zoneId>,... then per zone:
+//   WeatherVibe.ZoneOverride.<zoneId>.Weights     = <state>=<abs|+delta|-delta>,...
+//   WeatherVibe.ZoneOverride.<zoneId>.Percent.Min = <abs|+delta|-delta>
+//   WeatherVibe.ZoneOverride.<zoneId>.Percent.Max = <abs|+delta|-delta>
+static void LoadZoneOverrides(ConfigTables& t)
+{
+    t.zoneOverrides.clear();
+
+    std::string key;
+    static std::string const kZonesKey = "WeatherVibe.ZoneOverride.Zones";
+    std::string_view zones = ConfigText(kZonesKey, "");
+    ForEachToken(zones, ',', [&](std::string_view tok, size_t index)
+    {
+        uint32 zone = 0;
+        if (!ParseUInt(tok, zone) || !zone)
+        {
+            ReportParseError(kZonesKey, index, tok, "is not a zone id");
+            return;
+        }
+
+        key.assign("WeatherVibe.ZoneOverride.").append(tok).append(1, '.');
+        size_t const baseLen = key.size();
+        ProfileLayer& ov = t.zoneOverrides[zone];
+        ov = ProfileLayer{};
+        ParseLayerKeys(key, baseLen, ov);
+    });
+}
+
+// "WeatherVibe.Profile.<Name>.Next.<stateId> = <state>=<weight>,..." -> one alias row per configured
+// current state. Read from config even when the profiles come from a pack.
+static void LoadTransitions(ConfigTables& t)
+{
+    t.transitions.clear();
+
+    std::string key;
+    for (auto& kv : t.profiles)
+    {
+        Profile& p = *kv.second;
+        p.transitions = 0;
+
+        TransitionTable table;
+        bool any = false;
+        for (size_t i = 0; i < kStateCount; ++i)
+        {
+            key.assign("WeatherVibe.Profile.").append(p.name).append(".Next.").append(std::to_string((uint32)kAcceptedStates[i]));
+            std::string_view row = ConfigText(key, "");
+            if (TrimView(row).empty())
+                continue;
+            ParseWeights(key, row, table.weights[i]);
+            BuildSampler(table.weights[i], table.rows[i]);
+            any |= !table.rows[i].empty;
+        }
+
+        if (any && t.transitions.size() < UINT16_MAX)
+        {
+            t.transitions.push_back(table);
+            p.transitions = uint16(t.transitions.size());
+        }
+    }
+}
+
+// "<areaId>=<profile>,..." -> dense area index; areas must be sub-zones in AreaTable
+static void LoadAreaControllers(ConfigTables& t)
+{
+    t.areaControllers.assign(1, AreaController{});
+    t.areaSlot.clear();
+
+    static std::string const kAreaMapKey = "WeatherVibe.AreaProfile.Map";
+    std::string_view apm = ConfigText(kAreaMapKey, "");
+    ForEachToken(apm, ',', [&](std::string_view tok, size_t index)
+    {
+        std::string_view lhs, rhs;
+        uint32 area = 0;
+        if (!SplitPair(tok, '=', lhs, rhs) || !ParseUInt(lhs, area) || !area)
+        {
+            ReportParseError(kAreaMapKey, index, tok, "is not '<areaId>=<profile>'");
+            return;
+        }
+        AreaTableEntry const* entry = sAreaTableStore.LookupEntry(area);
+        if (!entry || !entry->zone)
+        {
+            ReportParseError(kAreaMapKey, index, tok, "is not a sub-zone area (zones go in ZoneProfile.Map)");
+            return;
+        }
+        if (area < t.areaSlot.size() && t.areaSlot[area])
+        {
+            ReportParseError(kAreaMapKey, index, tok, "maps the same area twice");
+            return;
+        }
+        if (t.areaControllers.size() > UINT16_MAX)
+        {
+            ReportParseError(kAreaMapKey, index, tok, "exceeds the area controller limit");
+            return;
+        }
+
+        AreaController ac;
+        ac.area = area;
+        ac.zone = entry->zone;
+        AssignLower(ac.profile, rhs);
+        if (!t.profiles.count(ac.profile))
+            ReportParseError(kAreaMapKey, index, tok, "references an unknown profile (falls back at runtime)");
+
+        if (area >= t.areaSlot.size())
+            t.areaSlot.resize(area + 1, 0);
+        t.areaSlot[area] = (uint16)t.areaControllers.size();
+        t.areaControllers.push_back(std::move(ac));
+    });
+}
+
+// "<zoneA>-<zoneB>,..." undirected links between controller zones
+static void LoadSpilloverLinks(ConfigTables& t)
+{
+    t.spillLinks.clear();
+
+    static std::string const kLinksKey = "WeatherVibe.Spillover.Links";
+    std::string_view links = ConfigText(kLinksKey, "");
+    ForEachToken(links, ',', [&](std::string_view tok, size_t index)
+    {
+        std::string_view lhs, rhs;
+        uint32 a = 0, b = 0;
+        if (!SplitPair(tok, '-', lhs, rhs) || !ParseUInt(lhs, a) || !ParseUInt(rhs, b) || !a || !b || a == b)
+        {
+            ReportParseError(kLinksKey, index, tok, "is not '<zoneA>-<zoneB>'");
+            return;
+        }
+        t.spillLinks.emplace_back(a, b);
+    });
+}
+
+// Builds the CSR adjacency over controller zones (children collapse onto their controller).
+static void BuildSpilloverGraph(ConfigTables& t)
+{
+    t.spillZoneNode.clear();
+    t.spillNodeZone.clear();
+
+    std::vector<std::pair<uint32, uint32>> edges; // node pairs, both directions
+    edges.reserve(t.spillLinks.size() * 2);
+    auto nodeOf = [&t](uint32 zone)
+    {
+        auto [it, added] = t.spillZoneNode.try_emplace(ResolveControllerZone(t, zone), (uint32)t.spillNodeZone.size());
+        if (added) t.spillNodeZone.push_back(it->first);
+        return it->second;
+    };
+    for (auto const& [a, b] : t.spillLinks)
+    {
+        uint32 na = nodeOf(a), nb = nodeOf(b);
+        if (na == nb) continue;
+        edges.emplace_back(na, nb);
+        edges.emplace_back(nb, na);
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    size_t const nodes = t.spillNodeZone.size();
+    t.spillAdjOffsets.assign(nodes + 1, 0);
+    t.spillAdj.resize(edges.size());
+    for (auto const& e : edges) ++t.spillAdjOffsets[e.first + 1];
+    for (size_t n = 0; n < nodes; ++n) t.spillAdjOffsets[n + 1] += t.spillAdjOffsets[n];
+    for (size_t i = 0; i < edges.size(); ++i) t.spillAdj[i] = edges[i].second; // edges sorted by source
+}
+
+static void LoadAutoConfig(ConfigTables& t)
+{
+    t.autoEnabled = ConfigOption<uint32>("WeatherVibe.Auto.Enable", 0) != 0;
+    t.autoTickMs = ConfigOption<uint32>("WeatherVibe.Auto.TickMs", 1000);
+    if (t.autoTickMs == 0)
+    {
+        // the tween planner steps by the tick and the nudge math divides by it
+        ReportParseError("WeatherVibe.Auto.TickMs", 0, "0", "must be at least 1; using 1");
+        t.autoTickMs = 1;
+    }
+    t.minWindowSec = ConfigOption<uint32>("WeatherVibe.Auto.MinWindowSec", 180);
+    t.maxWindowSec = ConfigOption<uint32>("WeatherVibe.Auto.MaxWindowSec", 480);
+    t.tweenSec = ConfigOption<uint32>("WeatherVibe.Auto.TweenSec", 20);
+
+    std::string_view curve = TrimView(ConfigText("WeatherVibe.Auto.TweenCurve", "linear"));
+    t.tweenCurve = TweenCurve::LINEAR;
+    for (uint8 c = 0; c < (uint8)TweenCurve::COUNT; ++c)
+        if (EqualsNoCase(curve, TweenCurveName((TweenCurve)c)))
+            t.tweenCurve = (TweenCurve)c;
+    // kept above zero: a zero threshold would resend an unchanged grade on every tick
+    t.tinyNudge = std::max(kMinGrade, ConfigOption<float>("WeatherVibe.Auto.TinyNudge", 0.01f));
+
+    t.packetBudget = std::max(0.0f, ConfigOption<float>("WeatherVibe.Auto.PacketBudget", 0.0f));
+    t.nudgeMin = std::max(0.0f, ConfigOption<float>("WeatherVibe.Auto.NudgeMin", 0.002f));
+    t.nudgeMax = std::max(t.nudgeMin, ConfigOption<float>("WeatherVibe.Auto.NudgeMax", 0.10f));
+    t.rateWindowSec = std::max<uint32>(1, ConfigOption<uint32>("WeatherVibe.Auto.RateWindowSec", 60));
+    t.minSendIntervalMs = t.packetBudget > 0.0f ? uint32(60000.0f / t.packetBudget) : 0;
+
+    t.spillEnabled = ConfigOption<uint32>("WeatherVibe.Spillover.Enable", 0) != 0;
+    t.spillDelaySec = ConfigOption<uint32>("WeatherVibe.Spillover.DelaySec", 120);
+    t.spillDecay = std::clamp(ConfigOption<float>("WeatherVibe.Spillover.Decay", 0.7f), 0.0f, 1.0f);
+    t.spillTriggerPct = ConfigOption<float>("WeatherVibe.Spillover.TriggerPct", 35.0f);
+    t.spillMinPct = ConfigOption<float>("WeatherVibe.Spillover.MinPct", 15.0f);
+    t.spillMaxHops = std::min<uint32>(ConfigOption<uint32>("WeatherVibe.Spillover.MaxHops", 3), 255);
+
+    t.regionSpreadPct = std::clamp(ConfigOption<float>("WeatherVibe.Region.SpreadPct", 10.0f), 0.0f, 100.0f);
+    t.regionNoisePct = std::clamp(ConfigOption<float>("WeatherVibe.Region.NoisePct", 5.0f), 0.0f, 100.0f);
+    t.regionStaggerSec = ConfigOption<uint32>("WeatherVibe.Region.StaggerSec", 90);
+}
+
+// ======================================
+// Precompiled profile pack
+// ======================================
+static uint32 PackChecksum(char const* data, size_t len)
+{
+    uint32 h = 2166136261u;
+    for (size_t i = 0; i < len; ++i)
+        h = (h ^ (uint8)data[i]) * 16777619u;
+    return h;
+}
+
+template <typename T>
+static void AppendRecord(std::vector<char>& out, T const& rec)
+{
+    char const* p = reinterpret_cast<char const*>(&rec);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+// Files written by commands (packs, sim traces) go under WeatherVibe.OutputDir: name must be relative
+// and stay inside it. Returns false with a reason otherwise.
+static bool ResolveOutputPath(std::string_view name, std::string& out, std::string& error)
+{
+    if (name.empty() || name.front() == '/' || name.front() == '\\' || name.find(':') != std::string_view::npos)
+    {
+        error = "path must be relative to WeatherVibe.OutputDir";
+        return false;
+    }
+    bool escapes = false;
+    ForEachToken(name, '/', [&](std::string_view part, size_t)
+    {
+        ForEachToken(part, '\\', [&](std::string_view leaf, size_t) { escapes |= leaf == ".."; });
+    });
+    if (escapes)
+    {
+        error = "path must not contain '..'";
+        return false;
+    }
+
+    out = sConfigMgr->GetOption<std::string>("WeatherVibe.OutputDir", "");
+    if (!out.empty() && out.back() != '/' && out.back() != '\\')
+        out += '/';
+    out.append(name);
+    return true;
+}
+
+// Compiles the currently loaded catalog into a pack file. Returns false with a reason on failure.
+static bool WriteProfilePack(std::string const& path, std::string& error)
+{
+    // deterministic profile order: sorted by lowered name
+    std::vector<std::string const*> names;
+    names.reserve(g_Profiles.size());
+    for (auto const& kv : g_Profiles)
+        names.push_back(&kv.first);
+    std::sort(names.begin(), names.end(), [](std::string const* a, std::string const* b) { return *a < *b; });
+
+    std::unordered_map<std::string, uint32> indexOf;
+    std::vector<char> body;
+    body.reserve(sizeof(g_StateRanges) + names.size() * sizeof(PackProfile) + (g_ZoneProfile.size() + g_ZoneParent.size()) * sizeof(PackPair));
+
+    body.insert(body.end(), reinterpret_cast<char const*>(g_StateRanges), reinterpret_cast<char const*>(g_StateRanges) + sizeof(g_StateRanges));
+
+    for (std::string const* key : names)
+    {
+        Profile const& p = *g_Profiles.at(*key);
+        if (p.name.size() >= kPackNameLen)
+        {
+            error = "profile name too long for pack: " + p.name;
+            return false;
+        }
+
+        PackProfile rec{};
+        std::memcpy(rec.name, p.name.data(), p.name.size());
+        for (size_t c = 0; c < kProfileCells; ++c)
+        {
+            ProfileCell const& cell = p.cells[c];
+            PackCell& out = rec.cells[c];
+            std::copy(cell.weights.begin(), cell.weights.end(), out.weights);
+            out.pctMin = cell.pctMin;
+            out.pctMax = cell.pctMax;
+        }
+        AppendRecord(body, rec);
+        indexOf[*key] = uint32(indexOf.size());
+    }
+
+    std::vector<PackPair> zoneMap, parents;
+    for (auto const& kv : g_ZoneProfile)
+        if (auto it = indexOf.find(kv.second); it != indexOf.end())
+            zoneMap.push_back({ kv.first, it->second }); // unknown profiles are dropped
+    for (auto const& kv : g_ZoneParent)
+        parents.push_back({ kv.first, kv.second });
+
+    auto byKey = [](PackPair const& a, PackPair const& b) { return a.key < b.key; };
+    std::sort(zoneMap.begin(), zoneMap.end(), byKey);
+    std::sort(parents.begin(), parents.end(), byKey);
+    for (PackPair const& rec : zoneMap) AppendRecord(body, rec);
+    for (PackPair const& rec : parents) AppendRecord(body, rec);
+    for (auto const& [a, b] : g_SpillLinks) AppendRecord(body, PackPair{ a, b });
+
+    PackHeader hdr{};
+    std::memcpy(hdr.magic, kPackMagic, sizeof(kPackMagic));
+    hdr.version = kPackVersion;
+    hdr.stateCount = kStateCount;
+    hdr.dayPartCount = (uint32)DayPart::COUNT;
+    hdr.seasonCount = (uint32)Season::COUNT;
+    hdr.profileCount = (uint32)names.size();
+    hdr.zoneMapCount = (uint32)zoneMap.size();
+    hdr.parentCount = (uint32)parents.size();
+    hdr.linkCount = (uint32)g_SpillLinks.size();
+    hdr.checksum = PackChecksum(body.data(), body.size());
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<char const*>(&hdr), sizeof(hdr));
+    out.write(body.data(), (std::streamsize)body.size());
+    if (!out)
+    {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+static bool IsFiniteRange(float lo, float hi)
+{
+    return std::isfinite(lo) && std::isfinite(hi) && lo <= hi;
+}
+
+// Checks the values the engine indexes or clamps with; the checksum only catches accidental damage.
+static bool ValidatePackBody(PackHeader const& hdr, char const* body, char const*& reason)
+{
+    Range ranges[(size_t)DayPart::COUNT][kStateCount];
+    std::memcpy(ranges, body, sizeof(ranges));
+    body += sizeof(ranges);
+    for (auto const& row : ranges)
+        for (Range const& r : row)
+            if (!IsFiniteRange(r.min, r.max) || r.min < 0.0f || r.max > 1.0f)
+                return (reason = "state range is not within 0..1 or has min > max"), false;
+
+    for (uint32 i = 0; i < hdr.profileCount; ++i, body += sizeof(PackProfile))
+    {
+        PackProfile rec;
+        std::memcpy(&rec, body, sizeof(rec));
+        for (PackCell const& cell : rec.cells)
+            if (!IsFiniteRange(cell.pctMin, cell.pctMax))
+                return (reason = "profile percent band is not finite or has min > max"), false;
+    }
+    body += size_t(hdr.zoneMapCount) * sizeof(PackPair);
+
+    std::unordered_map<uint32, uint32> parents;
+    for (uint32 i = 0; i < hdr.parentCount; ++i, body += sizeof(PackPair))
+    {
+        PackPair rec;
+        std::memcpy(&rec, body, sizeof(rec));
+        if (!rec.key || !rec.value || rec.key == rec.value || !parents.emplace(rec.key, rec.value).second)
+            return (reason = "zone parent is zero, self-referencing or a duplicate child"), false;
+    }
+    for (auto const& kv : parents)
+    {
+        uint32 cur = kv.first;
+        for (size_t hops = 0; hops <= parents.size(); ++hops)
+        {
+            auto it = parents.find(cur);
+            if (it == parents.end())
+                break;
+            if (hops == parents.size())
+                return (reason = "zone parents form a cycle"), false;
+            cur = it->second;
+        }
+    }
+    return true;
+}
+
+// Loads a pack into the catalog tables. The file is read in one go and validated
+// before anything is touched; records are bulk-copied, nothing is text-parsed. Alias tables are
+// rebuilt from the stored weights rather than trusted from the file.
+static bool LoadProfilePack(ConfigTables& t, std::string const& path)
+{
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in)
+    {
+        LOG_ERROR("server.loading", "[WeatherVibe] pack {}: cannot open", path);
+        return false;
+    }
+
+    std::streamoff const size = in.tellg();
+    if (size < 0 || (uint64)size > kPackMaxBytes)
+    {
+        LOG_ERROR("server.loading", "[WeatherVibe] pack {}: cannot determine a usable file size", path);
+        return false;
+    }
+
+    std::vector<char> buf((size_t)size);
+    in.seekg(0);
+    in.read(buf.data(), (std::streamsize)buf.size());
+
+    PackHeader hdr{};
+    if (!in || buf.size() < sizeof(hdr))
+    {
+        LOG_ERROR("server.loading", "[WeatherVibe] pack {}: truncated header", path);
+        return false;
+    }
+    std::memcpy(&hdr, buf.data(), sizeof(hdr));
+
+    size_t const expected = sizeof(hdr) + sizeof(t.stateRanges) + size_t(hdr.profileCount) * sizeof(PackProfile)
+        + (size_t(hdr.zoneMapCount) + hdr.parentCount + hdr.linkCount) * sizeof(PackPair);
+    char const* body = buf.data() + sizeof(hdr);
+
+    if (std::memcmp(hdr.magic, kPackMagic, sizeof(kPackMagic)) != 0 || hdr.version != kPackVersion
+        || hdr.stateCount != kStateCount || hdr.dayPartCount != (uint32)DayPart::COUNT || hdr.seasonCount != (uint32)Season::COUNT)
+    {
+        LOG_ERROR("server.loading", "[WeatherVibe] pack {}: not a v{} pack for this build (version {})", path, kPackVersion, hdr.version);
+        return false;
+    }
+    if (buf.size() != expected || PackChecksum(body, buf.size() - sizeof(hdr)) != hdr.checksum)
+    {
+        LOG_ERROR("server.loading", "[WeatherVibe] pack {}: size/checksum mismatch, rebuild it with .wvibe pack build", path);
+        return false;
+    }
+    char const* reason = nullptr;
+    if (!ValidatePackBody(hdr, body, reason))
+    {
+        LOG_ERROR("server.loading", "[WeatherVibe] pack {}: {}, rebuild it with .wvibe pack build", path, reason);
+        return false;
+    }
+
+    std::memcpy(t.stateRanges, body, sizeof(t.stateRanges));
+    body += sizeof(t.stateRanges);
+
+    t.profiles.clear();
+    std::vector<std::string const*> keyOf(hdr.profileCount);
+    std::string lowered;
+    for (uint32 i = 0; i < hdr.profileCount; ++i, body += sizeof(PackProfile))
+    {
+        PackProfile rec;
+        std::memcpy(&rec, body, sizeof(rec));
+        std::string_view name(rec.name, strnlen(rec.name, kPackNameLen));
+
+        AssignLower(lowered, name);
+        auto it = t.profiles.try_emplace(lowered).first;
+        it->second = std::make_shared<Profile>();
+        Profile& p = *it->second;
+        p.name.assign(name);
+        for (size_t c = 0; c < kProfileCells; ++c)
+        {
+            PackCell const& in = rec.cells[c];
+            ProfileCell& cell = p.cells[c];
+            std::copy(std::begin(in.weights), std::end(in.weights), cell.weights.begin());
+            cell.pctMin = in.pctMin;
+            cell.pctMax = in.pctMax;
+            BuildSampler(cell.weights, cell.sampler);
+        }
+        keyOf[i] = &it->first;
+    }
+
+    t.zoneProfile.clear();
+    for (uint32 i = 0; i < hdr.zoneMapCount; ++i, body += sizeof(PackPair))
+    {
+        PackPair rec;
+        std::memcpy(&rec, body, sizeof(rec));
+        if (rec.value < hdr.profileCount)
+            t.zoneProfile[rec.key] = *keyOf[rec.value];
+    }
+
+    t.zoneParent.clear();
+    t.zoneChildren.clear();
+    for (uint32 i = 0; i < hdr.parentCount; ++i, body += sizeof(PackPair))
+    {
+        PackPair rec;
+        std::memcpy(&rec, body, sizeof(rec));
+        t.zoneParent[rec.key] = rec.value;
+        t.zoneChildren[rec.value].push_back(rec.key);
+    }
+
+    t.spillLinks.clear();
+    for (uint32 i = 0; i < hdr.linkCount; ++i, body += sizeof(PackPair))
+    {
+        PackPair rec;
+        std::memcpy(&rec, body, sizeof(rec));
+        t.spillLinks.emplace_back(rec.key, rec.value);
+    }
+
+    return true;
+}
+
+// Parses and compiles every config-driven table from cfg into t; returns elapsed microseconds.
+// Besides t it only resets the calling thread's parse counters, so it may run on a background task.
+static uint64 ParseConfigTables(ConfigTables& t, ConfigSnapshot const& cfg)
+{
+    auto start = std::chrono::steady_clock::now();
+    ConfigSnapshotScope use(cfg);
+    g_ParseErrors = 0;
+
+    LoadDayPartConfig(t);
+
+    // catalog: precompiled pack when configured and valid, config strings otherwise
+    t.packFile.assign(TrimView(ConfigText("WeatherVibe.Pack.File", "")));
+    t.packActive = !t.packFile.empty() && LoadProfilePack(t, t.packFile);
+    if (!t.packActive)
+    {
+        LoadStateRanges(t);
+        LoadProfiles(t);
+        LoadZoneParents(t);
+        LoadSpilloverLinks(t);
+    }
+
+    LoadZoneOverrides(t); // always from config: small, layered on top of either catalog source
+    LoadTransitions(t);
+    LoadAreaControllers(t);
+    LoadAutoConfig(t);
+    LoadQuantization(t);
+    BuildDayBlendTable(t);
+    BuildSpilloverGraph(t);
+
+    return (uint64)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Keeps a scratch parse (bench) from clobbering the error count the last real load reported.
+class ParseCounterScope
+{
+public:
+    ParseCounterScope() : _errors(g_ParseErrors), _quiet(g_ParseQuiet) {}
+    ~ParseCounterScope() { g_ParseErrors = _errors; g_ParseQuiet = _quiet; }
+
+    ParseCounterScope(ParseCounterScope const&) = delete;
+    ParseCounterScope& operator=(ParseCounterScope const&) = delete;
+
+private:
+    uint32 _errors;
+    bool _quiet;
+};
+
+static void LogConfigSummary(uint64 parseUs)
+{
+    LOG_INFO("server.loading", "[WeatherVibe] config {} in {} us ({} profiles, {} with transitions, {} zone maps, {} area maps, {} zone parents, {} spillover links, {} errors)",
+        g_PackActive ? "loaded from pack" : "parsed", parseUs, g_Profiles.size(), g_Transitions.size(), g_ZoneProfile.size(), g_AreaControllers.size() - 1,
+        g_ZoneParent.size(), g_SpillLinks.size(), g_ParseErrors);
+}
+
+static WeatherState PickStateFromWeights(ProfileCell const& cell)
+{
+    return SampleState(cell.sampler);
+}
+
+// Next state after `from`: the profile's transition row when it has one, else the cell weights. A row
+// pick the cell gives no weight (not in this season/daypart's climate) falls back to the cell too.
+static WeatherState PickNextState(Profile const& profile, ProfileCell const& cell, WeatherState from)
+{
+    size_t row = StateIndex(from);
+    if (profile.transitions && profile.transitions <= g_Transitions.size() && row != kStateCount)
+    {
+        StateSampler const& next = g_Transitions[profile.transitions - 1].rows[row];
+        if (!next.empty)
+        {
+            WeatherState state = SampleState(next);
+            if (cell.weights[StateIndex(state)])
+                return state;
+        }
+    }
+    return PickStateFromWeights(cell);
+}
+
+static float RandPercentBetween(ProfileCell const& cell)
+{
+    if (cell.pctMax <= cell.pctMin) return cell.pctMin;
+    std::uniform_real_distribution<float> d(cell.pctMin, cell.pctMax);
+    return d(g_Rng);
+}
+
+// Eases t in [0,1] with the configured curve (table lookup + linear interpolation).
+static float EaseAt(TweenCurve curve, float t)
+{
+    auto const& lut = kEaseLut[(size_t)curve];
+    float x = std::clamp(t, 0.0f, 1.0f) * kEaseSteps;
+    size_t i = std::min<size_t>((size_t)x, kEaseSteps - 1);
+    return lut[i] + (lut[i + 1] - lut[i]) * (x - (float)i);
+}
+
+// Auto percent of the zone at atMs (closed form; curPct is only refreshed when the zone is stepped).
+static float TweenPctAt(AutoZone const& az, uint64 atMs)
+{
+    if (!az.tweenMs || atMs >= az.tweenStartMs + az.tweenMs)
+        return az.tgtPct;
+    if (atMs <= az.tweenStartMs)
+        return az.tweenFromPct;
+    float t = float(atMs - az.tweenStartMs) / float(az.tweenMs);
+    return az.tweenFromPct + (az.tgtPct - az.tweenFromPct) * EaseAt(g_TweenCurve, t);
+}
+
+// Starts a tween toward toPct from the percent shown on the previous tick (a sleeping zone's curPct
+// may be stale), read off the old tween before the target moves; progress is read off the engine clock.
+static void BeginTween(AutoZone& az, float toPct, uint32 diffMs)
+{
+    az.tweenFromPct = TweenPctAt(az, g_EngineNowMs - std::min<uint64>(diffMs, g_EngineNowMs));
+    az.tgtPct = toPct;
+    az.tweenStartMs = g_EngineNowMs;
+    az.tweenMs = g_TweenSec * 1000u;
+}
+
+static uint32 TweenRemainMs(AutoZone const& az)
+{
+    uint64 elapsed = g_EngineNowMs - az.tweenStartMs;
+    return elapsed >= az.tweenMs ? 0 : uint32(az.tweenMs - elapsed);
+}
+
+static uint32 RandWindowMs()
+{
+    if (g_MaxWindowSec < g_MinWindowSec) std::swap(g_MaxWindowSec, g_MinWindowSec);
+    std::uniform_int_distribution<uint32> d(g_MinWindowSec, g_MaxWindowSec);
+    return d(g_Rng) * 1000u;
+}
+
+// Region members never pick on their own: their next target arrives with the region's next pick.
+static uint64 NextWindowEndMs(AutoZone const& az)
+{
+    return az.region ? UINT64_MAX : g_EngineNowMs + RandWindowMs();
+}
+
+static void EnsureAutoZone(uint32 controllerZone)
+{
+    if (g_AutoZones.count(controllerZone)) return;
+    AutoZone az; az.enabled = false; // default off until mapped
+    g_AutoZones[controllerZone] = az;
+}
+
+// Drops a zone entry that no longer drives anything (auto off, no timeline, no sprinkles), so entries
+// made on demand by commands and timelines do not pile up. Queued wakes/expiries for it just miss.
+static bool PruneAutoZone(uint32 controllerZone)
+{
+    auto it = g_AutoZones.find(controllerZone);
+    if (it == g_AutoZones.end() || it->second.enabled || it->second.timeline.active || it->second.sprinkles.count)
+        return false;
+    g_AutoZones.erase(it);
+    return true;
+}
+
+// Queues a step of the zone at atMs, unless an earlier one is already queued (that one reschedules).
+static void ScheduleZoneWake(uint32 zone, AutoZone& az, uint64 atMs)
+{
+    if (atMs >= az.wakeMs) return;
+    az.wakeMs = atMs;
+    g_ZoneWakes.Push(atMs, { zone, az.wakeGen = ++g_WakeGen });
+}
+
+// Outside change (sprinkle, timeline, front, command): re-evaluate the zone on this tick.
+static void WakeZone(uint32 zone)
+{
+    auto it = g_AutoZones.find(zone);
+    if (it != g_AutoZones.end())
+        ScheduleZoneWake(zone, it->second, g_EngineNowMs);
+}
+
+// Points az.effective at the base profile, or at a flattened base + zone override copy owned by the
+// zone; runs once per (re)assignment, never per tick.
+static void ResolveEffectiveProfile(ConfigTables const& t, uint32 controllerZone, AutoZone& az)
+{
+    auto itp = t.profiles.find(az.profile);
+    if (itp == t.profiles.end())
+    {
+        // fallback: any default profile
+        if (!t.profiles.empty()) itp = t.profiles.begin();
+    }
+
+    az.effective = (itp != t.profiles.end()) ? itp->second : nullptr;
+    az.hasOverride = false;
+
+    auto ito = t.zoneOverrides.find(controllerZone);
+    if (ito == t.zoneOverrides.end() || itp == t.profiles.end())
+        return;
+
+    auto flat = std::make_shared<Profile>(*itp->second);
+    ProfileLayer const& ov = ito->second;
+    for (ProfileCell& cell : flat->cells)
+    {
+        ApplyLayer(ov, cell);
+        BuildSampler(cell.weights, cell.sampler);
+    }
+    az.effective = std::move(flat);
+    az.hasOverride = true;
+}
+
+static void ResolveEffectiveProfile(uint32 controllerZone, AutoZone& az)
+{
+    ResolveEffectiveProfile(g_Tables, controllerZone, az);
+}
+
+// What a zone table is built from: tables, last-applied snapshots, ranges for the current minute
+// and the engine clock. A reload task gets copies; nothing here points at live world state.
+struct ZoneBuildInput
+{
+    ConfigTables const& tables;
+    LastAppliedStore const& lastApplied;
+    Range const* ranges;
+    uint64 nowMs;
+};
+
+// Puts a mapped zone or area under auto control with a fresh state.
+static void InitAutoController(ZoneBuildInput const& in, std::unordered_map<uint32, AutoZone>& zones, uint32 controller, std::string const& profile)
+{
+    AutoZone& az = zones[controller];
+    az.enabled = true; // controlled because profile exists
+    az.profile = profile; // lowercased name
+    az.curState = WEATHER_STATE_FINE;
+    az.curPct = 0.0f;
+    az.tgtState = WEATHER_STATE_FINE;
+    az.tgtPct = 0.0f;
+    az.windowEndMs = 0;
+    az.tweenMs = 0;
+    az.lastRawSent = -1.0f;
+    az.lastStateSent = WEATHER_STATE_FINE;
+    az.nudge = std::clamp(in.tables.tinyNudge, in.tables.nudgeMin, in.tables.nudgeMax);
+    az.sendRate = 0.0f;
+    az.lastSendMs = in.nowMs;
+    az.sprinkles = SprinkleStack{};
+    ResolveEffectiveProfile(in.tables, controller, az);
+    SeedAutoFromLastApplied(in.lastApplied, in.ranges, controller, az);
+}
+
+static void BuildAutoZones(ZoneBuildInput const& in, std::unordered_map<uint32, AutoZone>& zones)
+{
+    zones.clear();
+    for (auto const& zprof : in.tables.zoneProfile)
+        InitAutoController(in, zones, ResolveControllerZone(in.tables, zprof.first), zprof.second);
+    for (size_t slot = 1; slot < in.tables.areaControllers.size(); ++slot)
+        InitAutoController(in, zones, in.tables.areaControllers[slot].area, in.tables.areaControllers[slot].profile);
+}
+
+static void SyncAutoWithManual(uint32 zoneIdRaw, WeatherState state, float rawGrade)
+{
+    if (!g_AutoEnabled) return;
+
+    uint32 controller = ResolveControllerZone(zoneIdRaw);
+    auto it = g_AutoZones.find(controller);
+    if (it == g_AutoZones.end() || !it->second.enabled) return;
+
+    AutoZone& az = it->second;
+    float pct = RawToPercent01(ActiveRanges(), state, rawGrade) * 100.0f;
+
+    az.curState = state; az.tgtState = state;
+    az.curPct = pct;   az.tgtPct = pct;
+    az.tweenMs = 0;
+
+    if (az.windowEndMs <= g_EngineNowMs) az.windowEndMs = g_EngineNowMs + RandWindowMs();
+
+    az.lastRawSent = ClampToCoreBounds(rawGrade, state);
+    az.lastStateSent = state;
+    ScheduleZoneWake(controller, az, g_EngineNowMs);
+}
+
+// ======================================
+// Regional spillover (fronts travel the adjacency graph)
+// ======================================
+static void PushFrontToNeighbours(uint32 node, uint32 frontId, WeatherState state, float pct, uint8 hops)
+{
+    if (hops >= g_SpillMaxHops || pct < g_SpillMinPct)
+        return;
+
+    uint64 due = g_EngineNowMs + uint64(g_SpillDelaySec) * 1000u;
+    for (uint32 i = g_SpillAdjOffsets[node]; i < g_SpillAdjOffsets[node + 1]; ++i)
+        if (g_SpillNodeFront[g_SpillAdj[i]] != frontId)
+            g_Fronts.Push(due, { g_SpillAdj[i], frontId, state, pct, uint8(hops + 1) });
+}
+
+// Called when a zone picks a fresh target; strong non-clear picks start a front.
+static void MaybeSpawnFront(uint32 controllerZone, WeatherState state, float pct)
+{
+    if (!g_SpillEnabled || state == WEATHER_STATE_FINE || pct < g_SpillTriggerPct)
+        return;
+
+    auto it = g_SpillZoneNode.find(controllerZone);
+    if (it == g_SpillZoneNode.end())
+        return;
+
+    uint32 frontId = g_NextFrontId++;
+    g_SpillNodeFront[it->second] = frontId;
+    PushFrontToNeighbours(it->second, frontId, state, pct * g_SpillDecay, 0);
+}
+
+// Pops only the arrivals that are due; zones without an active front cost nothing.
+static void ProcessDueFronts(size_t cellIndex, uint32 diffMs)
+{
+    while (g_Fronts.HasDue(g_EngineNowMs))
+    {
+        FrontArrival f = g_Fronts.PopDue();
+        if (g_SpillNodeFront[f.node] == f.frontId)
+            continue; // reached via a shorter path already
+        g_SpillNodeFront[f.node] = f.frontId;
+
+        auto it = g_AutoZones.find(g_SpillNodeZone[f.node]);
+        if (it == g_AutoZones.end() || !it->second.enabled)
+            continue;
+
+        // the front only takes hold where the zone's climate allows that state (no snow fronts into deserts)
+        AutoZone& az = it->second;
+        if (!az.effective)
+            continue;
+        ProfileCell const& cell = az.effective->cells[cellIndex];
+        size_t idx = StateIndex(f.state);
+        if (idx == kStateCount || cell.weights[idx] == 0)
+            continue;
+
+        az.tgtState = f.state;
+        az.windowEndMs = NextWindowEndMs(az);
+        BeginTween(az, std::clamp(f.pct, cell.pctMin, cell.pctMax), diffMs);
+        ScheduleZoneWake(it->first, az, g_EngineNowMs);
+
+        PushFrontToNeighbours(f.node, f.frontId, f.state, f.pct * g_SpillDecay, f.hops);
+    }
+}
+
+// ======================================
+// Timelines (scripted multi-step events)
+// ======================================
+// "<state>:<pct>:<sec>,..." e.g. "fog:40:600,thunders:80:300,fine:0:60"
+static void ParseTimelineSteps(std::string_view key, std::string_view text, std::vector<TimelineStep>& out)
+{
+    out.clear();
+    ForEachToken(text, ',', [&](std::string_view tok, size_t index)
+    {
+        std::string_view stateTok, rest, pctTok, secTok;
+        TimelineStep st{};
+        uint32 sec = 0;
+        if (!SplitPair(tok, ':', stateTok, rest) || !SplitPair(rest, ':', pctTok, secTok)
+            || !ParseStateToken(stateTok, st.state) || !ParseFloat(pctTok, st.pct) || !ParseUInt(secTok, sec))
+        {
+            ReportParseError(key, index, tok, "is not '<state>:<pct>:<sec>'");
+            return;
+        }
+        st.pct = std::clamp(st.pct, 0.0f, 100.0f);
+        st.durationMs = sec * 1000u;
+        out.push_back(st);
+    });
+}
+
+static void ParseTimelineZones(std::string_view key, std::string_view text, std::vector<uint32>& out)
+{
+    out.clear();
+    ForEachToken(text, ',', [&](std::string_view tok, size_t index)
+    {
+        uint32 zone = 0;
+        if (!ParseUInt(tok, zone) || !zone)
+        {
+            ReportParseError(key, index, tok, "is not a zone id");
+            return;
+        }
+        if (!sAreaTableStore.LookupEntry(zone))
+        {
+            ReportParseError(key, index, tok, "is not a known zone or area id");
+            return;
+        }
+        out.push_back(zone);
+    });
+}
+
+static Timeline* FindTimeline(std::string_view name, uint32* index = nullptr)
+{
+    for (uint32 i = 0; i < g_Timelines.size(); ++i)
+    {
+        if (!EqualsNoCase(g_Timelines[i].name, name)) continue;
+        if (index) *index = i;
+        return &g_Timelines[i];
+    }
+    return nullptr;
+}
+
+// Delay until the next local HH:MM; fired == true skips the occurrence that just triggered.
+static uint64 MsUntilDailyStart(int32 startMinute, bool fired)
+{
+    tm lt = GetLocalTimeSafe();
+    int32 nowSec = lt.tm_hour * 3600 + lt.tm_min * 60 + lt.tm_sec;
+    int32 delta = (startMinute * 60 - nowSec + 86400) % 86400;
+    if (fired && delta < 60) delta += 86400;
+    return uint64(delta) * 1000u;
+}
+
+static void ReleaseTimelineZones(uint32 index)
+{
+    for (uint32 zone : g_Timelines[index].zones)
+    {
+        auto it = g_AutoZones.find(ResolveControllerZone(zone));
+        if (it != g_AutoZones.end() && it->second.timeline.active && it->second.timeline.owner == index)
+        {
+            it->second.timeline.active = false; // auto pick (already running underneath) takes over
+            if (!PruneAutoZone(it->first))
+                ScheduleZoneWake(it->first, it->second, g_EngineNowMs);
+        }
+    }
+}
+
+static void StartTimeline(uint32 index)
+{
+    Timeline& tl = g_Timelines[index];
+    if (tl.run) ReleaseTimelineZones(index);
+    tl.run = g_NextTimelineRun++;
+    tl.step = 0;
+    g_TimelineQueue.Push(g_EngineNowMs, { index, tl.run, 0, TimelineAction::Step });
+}
+
+static void StopTimeline(uint32 index)
+{
+    if (!g_Timelines[index].run) return;
+    ReleaseTimelineZones(index);
+    g_Timelines[index].run = 0; // queued steps of this run turn stale
+}
+
+static void ApplyTimelineStep(uint32 index, uint32 step)
+{
+    Timeline& tl = g_Timelines[index];
+    if (step >= tl.steps.size())
+    {
+        StopTimeline(index);
+        return;
+    }
+
+    TimelineStep const& st = tl.steps[step];
+    for (uint32 zone : tl.zones)
+    {
+        uint32 controller = ResolveControllerZone(zone);
+        EnsureAutoZone(controller); // zones without a profile are driven only while the timeline runs
+        AutoZone& az = g_AutoZones[controller];
+        az.timeline = TimelineOverlay{ true, st.state, st.pct, index };
+        ScheduleZoneWake(controller, az, g_EngineNowMs);
+    }
+    tl.step = step;
+    g_TimelineQueue.Push(g_EngineNowMs + st.durationMs, { index, tl.run, step + 1, TimelineAction::Step });
+}
+
+// Pops due events only: O(log n) each, nothing when no timeline is scheduled.
+static void ProcessDueTimelines()
+{
+    while (g_TimelineQueue.HasDue(g_EngineNowMs))
+    {
+        TimelineEvent ev = g_TimelineQueue.PopDue();
+        if (ev.timeline >= g_Timelines.size())
+            continue;
+
+        if (ev.action == TimelineAction::DailyStart)
+        {
+            StartTimeline(ev.timeline);
+            g_TimelineQueue.Push(g_EngineNowMs + MsUntilDailyStart(g_Timelines[ev.timeline].startMinute, true), ev);
+        }
+        else if (ev.run == g_Timelines[ev.timeline].run)
+            ApplyTimelineStep(ev.timeline, ev.step);
+    }
+}
+
+// Loads WeatherVibe.Timeline.* and queues the daily starts. Runs after the auto zones are rebuilt.
+static void InitializeTimelinesFromConfig()
+{
+    g_Timelines.clear();
+    g_TimelineQueue.Clear();
+
+    std::string key = "WeatherVibe.Timeline.";
+    size_t const baseLen = key.size();
+    std::string_view names = ConfigText("WeatherVibe.Timeline.Names", "");
+    ForEachToken(names, ',', [&](std::string_view name, size_t)
+    {
+        if (FindTimeline(name))
+            return;
+
+        Timeline tl;
+        tl.name.assign(name);
+        key.resize(baseLen); key.append(name).append(".Zones");
+        ParseTimelineZones(key, ConfigText(key, ""), tl.zones);
+        key.resize(baseLen); key.append(name).append(".Steps");
+        ParseTimelineSteps(key, ConfigText(key, ""), tl.steps);
+        key.resize(baseLen); key.append(name).append(".Start");
+        std::string_view start = ConfigText(key, "");
+        if (!start.empty())
+        {
+            tl.startMinute = ParseHHMM(start, -1);
+            if (tl.startMinute < 0)
+                ReportParseError(key, 0, start, "is not HH:MM");
+        }
+
+        if (tl.zones.empty() || tl.steps.empty())
+        {
+            LOG_ERROR("server.loading", "[WeatherVibe] timeline '{}' needs Zones and Steps; skipped", tl.name);
+            ++g_ParseErrors;
+            return;
+        }
+        g_Timelines.push_back(std::move(tl));
+    });
+
+    for (uint32 i = 0; i < g_Timelines.size(); ++i)
+        if (g_Timelines[i].startMinute >= 0)
+            g_TimelineQueue.Push(g_EngineNowMs + MsUntilDailyStart(g_Timelines[i].startMinute, false), { i, 0, 0, TimelineAction::DailyStart });
+}
+
+// ======================================
+// Regions (one simulation, many zones)
+// ======================================
+static Region const* FindRegion(std::vector<Region> const& regions, std::string_view name)
+{
+    for (Region const& r : regions)
+        if (EqualsNoCase(r.name, name))
+            return &r;
+    return nullptr;
+}
+
+// Loads WeatherVibe.Region.* into out and binds the member zones of a freshly built zone table.
+static void BuildRegions(ConfigTables const& t, std::unordered_map<uint32, AutoZone>& zones, std::vector<Region>& out)
+{
+    out.clear();
+
+    std::string key = "WeatherVibe.Region.";
+    size_t const baseLen = key.size();
+    std::string_view names = ConfigText("WeatherVibe.Region.Names", "");
+    ForEachToken(names, ',', [&](std::string_view name, size_t)
+    {
+        if (FindRegion(out, name) || out.size() >= UINT16_MAX)
+            return;
+
+        Region r;
+        r.name.assign(name);
+        key.resize(baseLen); key.append(name).append(".Profile");
+        AssignLower(r.profile, TrimView(ConfigText(key, "")));
+        auto itp = t.profiles.find(r.profile);
+        if (itp == t.profiles.end())
+        {
+            LOG_ERROR("server.loading", "[WeatherVibe] region '{}' needs a known Profile; skipped", r.name);
+            ++g_ParseErrors;
+            return;
+        }
+        r.climate = *itp->second;
+
+        std::vector<uint32> listed;
+        key.resize(baseLen); key.append(name).append(".Zones");
+        ParseTimelineZones(key, ConfigText(key, ""), listed);
+        uint16 const slot = uint16(out.size() + 1);
+        for (uint32 zone : listed)
+        {
+            uint32 controller = ResolveControllerZone(t, zone);
+            auto it = zones.find(controller);
+            if (it == zones.end() || !it->second.enabled)
+            {
+                LOG_ERROR("server.loading", "[WeatherVibe] region '{}': zone {} has no auto profile; skipped", r.name, zone);
+                ++g_ParseErrors;
+                continue;
+            }
+            if (it->second.region)
+            {
+                if (it->second.region != slot)
+                {
+                    LOG_ERROR("server.loading", "[WeatherVibe] region '{}': zone {} already belongs to region '{}'; skipped",
+                        r.name, zone, out[it->second.region - 1].name);
+                    ++g_ParseErrors;
+                }
+                continue;
+            }
+            it->second.region = slot;
+            it->second.windowEndMs = UINT64_MAX; // never picks locally; the region's first order lands at once
+            r.zones.push_back(controller);
+        }
+
+        if (r.zones.empty())
+        {
+            LOG_ERROR("server.loading", "[WeatherVibe] region '{}' has no usable zones; skipped", r.name);
+            ++g_ParseErrors;
+            return;
+        }
+        out.push_back(std::move(r));
+    });
+
+    if (!out.empty())
+    {
+        size_t members = 0;
+        for (Region const& r : out) members += r.zones.size();
+        LOG_INFO("server.loading", "[WeatherVibe] {} regions driving {} zones", out.size(), members);
+    }
+}
+
+// Deterministic value in [-1, 1] for (zone, salt): per-zone offsets and noise without touching g_Rng.
+static float RegionJitter(uint32 zone, uint32 salt)
+{
+    uint32 h = zone * 0x9E3779B1u ^ salt * 0x85EBCA77u;
+    h ^= h >> 16; h *= 0x7FEB352Du;
+    h ^= h >> 15; h *= 0x846CA68Bu;
+    h ^= h >> 16;
+    return float(h) / float(UINT32_MAX) * 2.0f - 1.0f;
+}
+
+// A member takes the region pick: region percent + its fixed offset + this pick's noise, clamped to
+// its own band. Where its climate gives the state no weight, it picks locally for this window.
+static void ApplyRegionOrder(RegionOrder const& o, size_t cellIndex, uint32 diffMs)
+{
+    auto it = g_AutoZones.find(o.zone);
+    if (it == g_AutoZones.end() || !it->second.enabled || it->second.region != o.region || !it->second.effective)
+        return;
+
+    AutoZone& az = it->second;
+    ProfileCell const& cell = az.effective->cells[cellIndex];
+    size_t idx = StateIndex(o.state);
+    float pct;
+    if (idx != kStateCount && cell.weights[idx] != 0)
+    {
+        pct = o.pct + g_RegionSpreadPct * RegionJitter(o.zone, 0) + g_RegionNoisePct * RegionJitter(o.zone, o.pick);
+        pct = std::clamp(pct, cell.pctMin, cell.pctMax);
+        az.tgtState = o.state;
+    }
+    else
+    {
+        az.tgtState = PickNextState(*az.effective, cell, az.curState);
+        pct = RandPercentBetween(cell);
+    }
+    az.windowEndMs = UINT64_MAX;
+    BeginTween(az, pct, diffMs);
+    ScheduleZoneWake(o.zone, az, g_EngineNowMs);
+}
+
+// O(regions) per tick plus the due member orders; member zones are only touched when an order lands.
+static void ProcessDueRegions(size_t cellIndex, uint32 diffMs)
+{
+    uint64 const staggerMs = uint64(g_RegionStaggerSec) * 1000u;
+    for (size_t i = 0; i < g_Regions.size(); ++i)
+    {
+        Region& r = g_Regions[i];
+        if (g_EngineNowMs < r.windowEndMs)
+            continue;
+
+        ProfileCell const& cell = r.climate.cells[cellIndex];
+        r.state = PickNextState(r.climate, cell, r.state);
+        r.pct = RandPercentBetween(cell);
+        r.windowEndMs = g_EngineNowMs + RandWindowMs();
+        ++r.pick;
+        for (uint32 zone : r.zones)
+        {
+            // the first pick is not staggered: members hold their seeded weather until it arrives
+            uint64 delayMs = r.pick == 1 ? 0 : uint64((RegionJitter(zone, ~r.pick) + 1.0f) * 0.5f * float(staggerMs));
+            g_RegionOrders.Push(g_EngineNowMs + delayMs, { zone, uint16(i + 1), r.state, r.pct, r.pick });
+        }
+    }
+
+    while (g_RegionOrders.HasDue(g_EngineNowMs))
+        ApplyRegionOrder(g_RegionOrders.PopDue(), cellIndex, diffMs);
+}
+
+static void ChooseNewTarget(uint32 controllerZone, AutoZone& az, size_t cellIndex, uint32 diffMs)
+{
+    if (!az.effective)
+    {
+        // no profiles at all -> fine 0
+        az.tgtState = WEATHER_STATE_FINE;
+        az.windowEndMs = NextWindowEndMs(az);
+        BeginTween(az, 0.0f, diffMs);
+        return;
+    }
+
+    ProfileCell const& cell = az.effective->cells[cellIndex];
+    az.tgtState = PickNextState(*az.effective, cell, az.curState);
+    float pct = RandPercentBetween(cell);
+    az.windowEndMs = NextWindowEndMs(az);
+    BeginTween(az, pct, diffMs);
+
+    MaybeSpawnFront(controllerZone, az.tgtState, az.tgtPct);
+}
+
+static void ProcessDueSprinkleExpiry()
+{
+    while (g_SprinkleExpiry.HasDue(g_EngineNowMs))
+    {
+        SprinkleExpiry ex = g_SprinkleExpiry.PopDue();
+        auto it = g_AutoZones.find(ex.zone);
+        if (it != g_AutoZones.end() && it->second.sprinkles.Remove(ex.id))
+            ScheduleZoneWake(ex.zone, it->second, g_EngineNowMs);
+    }
+}
+
+// Everything one engine step needs besides the zone; the live tick and the simulator fill it differently.
+struct TickContext
+{
+    uint32 diffMs;
+    Range const* ranges;   // blended for the tick's minute
+    size_t cellIndex;      // (season, daypart) profile cell
+    float rateAlpha;       // EWMA weight of this tick in the send-rate estimate
+    bool autoPicks = true; // false = auto is off: only zones under a timeline are driven
+};
+
+static TickContext MakeTickContext(uint32 diffMs, Range const* ranges, size_t cellIndex)
+{
+    float alpha = 1.0f - std::exp(-(float)diffMs / (g_RateWindowSec * 1000.0f));
+    return TickContext{ diffMs, ranges, cellIndex, alpha };
+}
+
+// Send rate at engine time ms. The EWMA is stored as of the last send and only decays after it, in
+// closed form, so the value never depends on which ticks the zone happened to be stepped on.
+static float SendRateAt(AutoZone const& az, uint64 ms)
+{
+    return az.sendRate * std::exp(-float(ms - az.lastSendMs) / (g_RateWindowSec * 1000.0f));
+}
+
+static float SendRateNow(AutoZone const& az)
+{
+    return SendRateAt(az, g_EngineNowMs);
+}
+
+// Folds a send into the zone's send rate and, with a budget set, steers its nudge threshold by one
+// tick: over budget -> coarser steps, well under budget while tweening -> finer steps. NextWakeMs
+// keeps the zone stepped on every tick the threshold moves, so skipped ticks never owe an update.
+static void UpdateSendRate(AutoZone& az, TickContext const& ctx, bool sent)
+{
+    if (sent)
+    {
+        az.sendRate = SendRateNow(az) + ctx.rateAlpha * 60000.0f / (float)ctx.diffMs;
+        az.lastSendMs = g_EngineNowMs;
+    }
+
+    if (g_PacketBudget <= 0.0f)
+        return;
+    float const rate = SendRateNow(az);
+    if (rate > g_PacketBudget)
+        az.nudge = std::min(az.nudge * 1.10f, g_NudgeMax);
+    else if (az.tweenMs && rate < 0.5f * g_PacketBudget)
+        az.nudge = std::max(az.nudge * 0.95f, g_NudgeMin);
+}
+
+// First tick at which UpdateSendRate would move the nudge threshold, UINT64_MAX = not before an outside
+// wake. The rate only decays between steps: over budget (below the cap) moves it on the next tick, and
+// while tweening the first tick under half the budget is found by binary search.
+static uint64 NextNudgeMoveMs(AutoZone const& az, TickContext const& ctx)
+{
+    uint64 const next = g_EngineNowMs + ctx.diffMs;
+    if (SendRateAt(az, next) > g_PacketBudget && az.nudge < g_NudgeMax)
+        return next;
+    if (!az.tweenMs || az.nudge <= g_NudgeMin)
+        return UINT64_MAX;
+
+    uint64 const endMs = az.tweenStartMs + az.tweenMs;
+    if (next >= endMs)
+        return UINT64_MAX;
+    auto under = [&](uint64 k) { return SendRateAt(az, g_EngineNowMs + k * ctx.diffMs) < 0.5f * g_PacketBudget; };
+    uint64 lo = 1, hi = (endMs - g_EngineNowMs - 1) / ctx.diffMs; // last tick still inside the tween
+    if (!under(hi))
+        return UINT64_MAX;
+    while (lo < hi)
+    {
+        uint64 mid = lo + (hi - lo) / 2;
+        if (under(mid)) hi = mid; else lo = mid + 1;
+    }
+    return g_EngineNowMs + lo * ctx.diffMs;
+}
+
+// Advances one zone to now. Returns true when the nudge filter wants a packet (out* hold it);
+// the caller decides what sending means. held = the threshold wants a send but the budget's interval holds it.
+static bool StepAutoZone(uint32 controllerZone, AutoZone& az, TickContext const& ctx, WeatherState& outState, float& outNorm, bool& held)
+{
+    held = false;
+    bool const picks = az.enabled && ctx.autoPicks;
+    if (!picks && !az.timeline.active) return false;
+
+    // auto keeps rotating under a timeline; zones without a profile (or with auto off) only carry the overlay
+    if (picks)
+    {
+        // choose a new target once the window is over
+        if (g_EngineNowMs >= az.windowEndMs)
+            ChooseNewTarget(controllerZone, az, ctx.cellIndex, ctx.diffMs);
+
+        // adopt the new weather STATE immediately; intensity follows a closed-form curve from the
+        // tween's start percent, so the ramp is the same whatever TickMs is (or a sprinkle on top)
+        az.curState = az.tgtState;
+        az.curPct = TweenPctAt(az, g_EngineNowMs);
+        if (TweenRemainMs(az) == 0)
+            az.tweenMs = 0;
+    }
+
+    // Decide what to push this tick: sprinkle > timeline step > auto
+    outState = az.curState;
+    float outPct = az.curPct;
+    if (Sprinkle const* sp = az.sprinkles.Top()) { outState = sp->state; outPct = sp->pct; }
+    else if (az.timeline.active) { outState = az.timeline.state; outPct = az.timeline.pct; }
+
+    // Map percent to raw grade for CURRENT daypart (dynamic bands, blended near boundaries), snapped to
+    // a visual level when quantized: an unchanged level is a zero delta and never goes out
+    outNorm = AutoGradeFor(ctx.ranges, outState, outPct);
+
+    // tiny nudge filter (fixed, or adaptive per zone with a packet budget); state changes always go out
+    float delta = (az.lastRawSent < 0.0f) ? 1.0f : std::fabs(outNorm - az.lastRawSent);
+    bool stateChanged = (outState != az.lastStateSent);
+    bool send = stateChanged;
+    if (!send && g_PacketBudget > 0.0f)
+        send = delta >= az.nudge && g_EngineNowMs - az.lastSendMs >= g_MinSendIntervalMs;
+    else if (!send)
+        send = delta >= g_TinyNudge;
+
+    UpdateSendRate(az, ctx, send);
+    // against the threshold the next tick will use: a finer nudge can make an unchanged output due
+    held = !send && g_PacketBudget > 0.0f && delta >= az.nudge;
+    if (!send)
+        return false;
+
+    az.lastRawSent = outNorm;
+    az.lastStateSent = outState;
+    return true;
+}
+
+// First tick at which the running tween moves the raw grade a nudge away from the last send, or the
+// tween's final tick. The curve and the percent->raw map are monotone and the zone starts within a
+// nudge of its last send, so the crossing ticks form a suffix: binary search, O(log ticks).
+static uint64 NextNudgeCrossingMs(AutoZone const& az, TickContext const& ctx)
+{
+    uint64 const endMs = az.tweenStartMs + az.tweenMs;
+    uint64 const ticks = (endMs - g_EngineNowMs + ctx.diffMs - 1) / ctx.diffMs;
+    float const nudge = g_PacketBudget > 0.0f ? az.nudge : g_TinyNudge;
+
+    auto crosses = [&](uint64 k)
+    {
+        float norm = AutoGradeFor(ctx.ranges, az.curState, TweenPctAt(az, g_EngineNowMs + k * ctx.diffMs));
+        return std::fabs(norm - az.lastRawSent) >= nudge;
+    };
+
+    // a zone mid-ramp usually crosses on the very next tick
+    if (ticks <= 1 || crosses(1))
+        return g_EngineNowMs + ctx.diffMs;
+
+    uint64 lo = 2, hi = ticks;
+    while (lo < hi)
+    {
+        uint64 mid = lo + (hi - lo) / 2;
+        if (crosses(mid)) hi = mid; else lo = mid + 1;
+    }
+    return g_EngineNowMs + lo * ctx.diffMs;
+}
+
+// Earliest time the zone's output can change on its own; outside changes wake it explicitly.
+static uint64 NextWakeMs(AutoZone const& az, TickContext const& ctx, bool held)
+{
+    uint64 wake = UINT64_MAX;
+    if (az.enabled && ctx.autoPicks)
+    {
+        wake = az.windowEndMs;
+        bool overlaid = az.sprinkles.Top() || az.timeline.active; // output is constant while overlaid
+        if (az.tweenMs && !overlaid)
+            wake = std::min(wake, NextNudgeCrossingMs(az, ctx));
+    }
+    if (held)
+        wake = std::min(wake, az.lastSendMs + g_MinSendIntervalMs);
+    if (g_PacketBudget > 0.0f)
+        wake = std::min(wake, NextNudgeMoveMs(az, ctx));
+    return wake == UINT64_MAX ? wake : std::max(wake, g_EngineNowMs + ctx.diffMs);
+}
+
+static void WakeAllOnContextChange(ContextWatch& watch, TickContext const& ctx)
+{
+    bool same = ctx.cellIndex == watch.cellIndex
+        && std::equal(watch.ranges.begin(), watch.ranges.end(), ctx.ranges, [](Range const& a, Range const& b) { return a.min == b.min && a.max == b.max; });
+    if (same)
+        return;
+
+    watch.cellIndex = ctx.cellIndex;
+    std::copy(ctx.ranges, ctx.ranges + kStateCount, watch.ranges.begin());
+    for (auto& kv : g_AutoZones)
+        ScheduleZoneWake(kv.first, kv.second, g_EngineNowMs);
+}
+
+// Steps only the zones whose wake is due; emit(zone, state, norm) receives each packet to send.
+template <typename Emit>
+static void RunDueZones(TickContext const& ctx, Emit&& emit)
+{
+    auto step = [&](ZoneWake w)
+    {
+        auto it = g_AutoZones.find(w.zone);
+        if (it == g_AutoZones.end() || it->second.wakeGen != w.gen)
+            return;
+
+        AutoZone& az = it->second;
+        az.wakeMs = UINT64_MAX;
+
+        WeatherState outState;
+        float norm;
+        bool held;
+        if (StepAutoZone(w.zone, az, ctx, outState, norm, held))
+            emit(w.zone, outState, norm);
+
+        uint64 next = NextWakeMs(az, ctx, held);
+        if (next == g_EngineNowMs + ctx.diffMs)
+        {
+            az.wakeMs = next;
+            g_NextTickWakes.push_back({ w.zone, az.wakeGen = ++g_WakeGen });
+        }
+        else if (next != UINT64_MAX)
+            ScheduleZoneWake(w.zone, az, next);
+    };
+
+    std::vector<ZoneWake> lane;
+    lane.swap(g_NextTickWakes);
+    g_NextTickWakes.reserve(lane.size());
+    for (ZoneWake w : lane)
+        step(w);
+    while (g_ZoneWakes.HasDue(g_EngineNowMs))
+        step(g_ZoneWakes.PopDue());
+}
+
+static bool AnyTimelineRunning()
+{
+    return std::any_of(g_Timelines.begin(), g_Timelines.end(), [](Timeline const& tl) { return tl.run != 0; });
+}
+
+// One engine tick at the current season/daypart; emit(zone, state, norm) receives each packet to send.
+template <typename Emit>
+static void RunEngineTick(uint32 diffMs, ContextWatch& watch, Emit&& emit)
+{
+    // the clock and timelines keep running while auto is off so scheduled events stay on time
+    g_EngineNowMs += diffMs;
+    ProcessDueTimelines();
+    ProcessDueSprinkleExpiry();
+
+    // with auto off only a running timeline drives its zones (a scripted event still plays)
+    if (!g_AutoEnabled && !AnyTimelineRunning()) return;
+
+    TickContext ctx = MakeTickContext(diffMs, ActiveRanges(), CellIndex(GetCurrentSeason(), GetCurrentDayPart()));
+    ctx.autoPicks = g_AutoEnabled;
+    if (ctx.autoPicks)
+    {
+        ProcessDueFronts(ctx.cellIndex, ctx.diffMs);
+        ProcessDueRegions(ctx.cellIndex, ctx.diffMs);
+    }
+    WakeAllOnContextChange(watch, ctx);
+
+    RunDueZones(ctx, emit);
+}
+
+static void ApplyAutoTick(uint32 diffMs)
+{
+    RunEngineTick(diffMs, g_LiveContext, [](uint32 zone, WeatherState state, float norm) { PushWeatherToClient(zone, state, norm); });
+}
+
+// ======================================
+// Config reload (built off the world thread, installed on it)
+// ======================================
+// Everything a reload produces. BuildReload reads only the config snapshot and the copies it is
+// handed, so it may run on a background task; InstallReload swaps the result in on the world thread.
+struct ReloadResult
+{
+    std::shared_ptr<ConfigSnapshot const> config; // taken on the world thread
+    ConfigTables tables;
+    std::unordered_map<uint32, AutoZone> zones;
+    std::vector<Region> regions;
+    uint32 parseErrors = 0;
+    uint64 parseUs = 0;
+    uint64 buildUs = 0; // auto zones + regions
+};
+
+static void BuildReload(ReloadResult& r, LastAppliedStore const& lastApplied, uint64 nowMs)
+{
+    ConfigSnapshotScope use(*r.config);
+    r.parseUs = ParseConfigTables(r.tables, *r.config);
+
+    auto start = std::chrono::steady_clock::now();
+    Range ranges[kStateCount];
+    BlendRangesForKey(r.tables, RangesKeyAt(r.tables, GetMinuteOfDay()), ranges);
+    BuildAutoZones(ZoneBuildInput{ r.tables, lastApplied, ranges, nowMs }, r.zones);
+    BuildRegions(r.tables, r.zones, r.regions);
+    r.buildUs = (uint64)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    r.parseErrors = g_ParseErrors;
+}
+
+// World thread only. Drops everything queued against the old tables; timelines are loaded here (they
+// are small and queue against the engine clock).
+static void InstallReload(ReloadResult& r)
+{
+    std::swap(g_Tables, r.tables);
+    g_ActiveRangesKey = -1;
+
+    g_Fronts.Clear();
+    g_SpillNodeFront.assign(g_SpillNodeZone.size(), 0);
+
+    std::swap(g_AutoZones, r.zones);
+    g_SprinkleExpiry.Clear();
+    g_ZoneWakes.Clear();
+    g_NextTickWakes.clear();
+    g_LiveContext = ContextWatch{}; // first tick sees a context change and wakes every zone
+
+    std::swap(g_Regions, r.regions);
+    g_RegionOrders.Clear();
+
+    RebuildAreaOccupancy();
+    g_ParseErrors = r.parseErrors;
+    ConfigSnapshotScope use(*r.config);
+    InitializeTimelinesFromConfig();
+}
+
+// ======================================
+// Background commands (heavy work off the world thread)
+// ======================================
+// Runs work on a background task and its finish step on a later world tick. Console commands (no
+// player to answer later) run both in place.
+static void RunInBackground(ChatHandler* handler, std::function<CommandFinish()> work)
+{
+    Player* player = handler->GetPlayer();
+    if (!player)
+    {
+        work()(handler);
+        return;
+    }
+    g_PendingCommands.push_back({ player->GetGUID(), std::async(std::launch::async, std::move(work)) });
+}
+
+// Runs a finish step for its requester, or with no handler once they logged out.
+static void FinishFor(ObjectGuid requester, CommandFinish const& finish)
+{
+    if (Player* player = ObjectAccessor::FindPlayer(requester))
+    {
+        ChatHandler handler(player->GetSession());
+        finish(&handler);
+    }
+    else
+        finish(nullptr);
+}
+
+// Called from WorldScript::OnUpdate; never blocks on a task still running.
+static void DrainBackgroundCommands()
+{
+    for (size_t i = 0; i < g_PendingCommands.size();)
+    {
+        PendingCommand& pc = g_PendingCommands[i];
+        if (pc.result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            ++i;
+            continue;
+        }
+
+        CommandFinish finish = pc.result.get();
+        ObjectGuid requester = pc.requester;
+        g_PendingCommands.erase(g_PendingCommands.begin() + i);
+        FinishFor(requester, finish);
+    }
+}
+
+// Called from WorldScript::OnShutdown: joins the tasks still running (they only read their own copies)
+// and drops their replies along with every queued sliced command.
+static void CancelCommands()
+{
+    for (PendingCommand& pc : g_PendingCommands)
+        pc.result.wait();
+    g_PendingCommands.clear();
+    g_ReloadPending = false;
+    g_SlicedCommands.clear();
+}
+
+// ======================================
+// Sliced commands (long diagnostics spread over world updates)
+// ======================================
+constexpr uint32 kSliceBudgetMs = 10; // world-thread time the sliced commands may take per update
+constexpr size_t kMaxSlicedCommands = 4; // queued at once; each steps its own copy of the engine state
+
+// Queues work that steps private engine state on the world thread, kSliceBudgetMs per update, and
+// answers once it is done. Console commands (no player to answer later) run every slice in place.
+static void RunInSlices(ChatHandler* handler, CommandSlice step)
+{
+    Player* player = handler->GetPlayer();
+    if (!player)
+    {
+        CommandFinish finish;
+        while (!(finish = step(SliceClock::time_point::max())))
+            ;
+        finish(handler);
+        return;
+    }
+    g_SlicedCommands.push_back({ player->GetGUID(), std::move(step) });
+}
+
+// Called from WorldScript::OnUpdate: the oldest queued command first, until the budget is spent.
+static void StepSlicedCommands()
+{
+    auto const deadline = SliceClock::now() + std::chrono::milliseconds(kSliceBudgetMs);
+    while (!g_SlicedCommands.empty() && SliceClock::now() < deadline)
+    {
+        CommandFinish finish = g_SlicedCommands.front().step(deadline);
+        if (!finish)
+            return;
+
+        ObjectGuid requester = g_SlicedCommands.front().requester;
+        g_SlicedCommands.pop_front();
+        FinishFor(requester, finish);
+    }
+}
+
+// ======================================
+// Fast-forward simulation (offline profile tuning)
+// ======================================
+constexpr uint32 kMaxSimDays = 60;
+
+// Per-zone results, column-major: one vector per metric, row i is zones[i].
+struct SimTrace
+{
+    uint32 days = 0;
+    uint32 tickMs = 0;
+    uint32 seed = 0;
+    uint64 wallUs = 0;
+    std::vector<uint32> zones;
+    std::vector<std::string> profiles;
+    std::vector<uint32> pushes;                         // packets the nudge filter let through
+    std::vector<uint32> changes;                        // visible state changes
+    std::array<std::vector<uint64>, kStateCount> stateMs; // time shown per state (by kAcceptedStates index)
+};
+
+// The engine's runtime state: zones, queues, clock and RNG. Swap() exchanges it with the globals, so a
+// simulation steps a private copy and never touches the live one.
+struct EngineState
+{
+    std::unordered_map<uint32, AutoZone> zones;
+    uint64 nowMs = 0;
+    TimedQueue<FrontArrival> fronts;
+    std::vector<uint32> spillNodeFront;
+    std::vector<Region> regions;
+    TimedQueue<RegionOrder> regionOrders;
+    TimedQueue<SprinkleExpiry> sprinkleExpiry;
+    TimedQueue<TimelineEvent> timelines;
+    TimedQueue<ZoneWake> wakes;
+    std::vector<ZoneWake> nextTickWakes;
+    std::mt19937 rng;
+
+    // A copy of the live state to simulate from. Timelines are not simulated (their daily starts follow
+    // the wall clock), and nothing is queued, so the first simulated tick wakes every zone.
+    static EngineState CopyOfLive(uint32 seed)
+    {
+        EngineState state;
+        state.zones = g_AutoZones;
+        state.nowMs = g_EngineNowMs;
+        state.fronts = g_Fronts;
+        state.spillNodeFront = g_SpillNodeFront;
+        state.regions = g_Regions;
+        state.regionOrders = g_RegionOrders;
+        state.sprinkleExpiry = g_SprinkleExpiry;
+        state.rng.seed(seed);
+        for (auto& kv : state.zones)
+        {
+            kv.second.timeline.active = false;
+            kv.second.wakeMs = UINT64_MAX;
+        }
+        return state;
+    }
+
+    void Swap()
+    {
+        std::swap(zones, g_AutoZones);
+        std::swap(nowMs, g_EngineNowMs);
+        std::swap(fronts, g_Fronts);
+        std::swap(spillNodeFront, g_SpillNodeFront);
+        std::swap(regions, g_Regions);
+        std::swap(regionOrders, g_RegionOrders);
+        std::swap(sprinkleExpiry, g_SprinkleExpiry);
+        std::swap(timelines, g_TimelineQueue);
+        std::swap(wakes, g_ZoneWakes);
+        std::swap(nextTickWakes, g_NextTickWakes);
+        std::swap(rng, g_Rng);
+    }
+};
+
+// Puts a private state in place of the globals it mirrors for the scope's lifetime: a whole run, or
+// one slice of a sliced command.
+template <typename State>
+class SwapScope
+{
+public:
+    explicit SwapScope(State& state) : _state(state) { _state.Swap(); }
+    ~SwapScope() { _state.Swap(); }
+
+    SwapScope(SwapScope const&) = delete;
+    SwapScope& operator=(SwapScope const&) = delete;
+
+private:
+    State& _state;
+};
+
+// Runs the auto engine (targets, tween, sprinkles, spillover, nudge filter) for `days` simulated days
+// from the current local time, starting from the live zone state. Step advances it until a deadline,
+// so a long run spreads over world updates; wallUs counts only the time spent stepping.
+class SimRun
+{
+public:
+    SimRun(uint32 days, uint32 seed) : _state(EngineState::CopyOfLive(seed)), _lt(GetLocalTimeSafe())
+    {
+        _trace.days = days;
+        _trace.tickMs = g_AutoTickMs;
+        _trace.seed = seed;
+
+        // stable zone order and dense rows
+        std::vector<std::pair<uint32, AutoZone const*>> rows;
+        for (auto const& kv : _state.zones)
+            if (kv.second.enabled)
+                rows.emplace_back(kv.first, &kv.second);
+        std::sort(rows.begin(), rows.end(), [](auto const& a, auto const& b) { return a.first < b.first; });
+
+        size_t const n = rows.size();
+        for (size_t i = 0; i < n; ++i)
+        {
+            _trace.zones.push_back(rows[i].first);
+            _trace.profiles.push_back(rows[i].second->profile);
+            _rowOf[rows[i].first] = i;
+            _shown.push_back(rows[i].second->lastStateSent);
+        }
+        _trace.pushes.assign(n, 0);
+        _trace.changes.assign(n, 0);
+        for (auto& col : _trace.stateMs)
+            col.assign(n, 0);
+        _shownSince.assign(n, 0);
+
+        _startMs = (uint64(_lt.tm_hour) * 60 + _lt.tm_min) * 60000u;
+        _totalMs = uint64(days) * 86400000u;
+        _ctx = MakeTickContext(_trace.tickMs, _ranges, 0);
+    }
+
+    SimRun(SimRun const&) = delete;
+    SimRun& operator=(SimRun const&) = delete;
+
+    // Returns true once every simulated day has run.
+    bool Step(SliceClock::time_point deadline)
+    {
+        auto start = SliceClock::now();
+        {
+            SwapScope<EngineState> in(_state);
+            for (uint32 n = 1; _simMs < _totalMs; ++n)
+            {
+                Tick();
+                _simMs += _trace.tickMs;
+                if (n % 16 == 0 && SliceClock::now() >= deadline)
+                    break;
+            }
+        }
+
+        bool const done = _simMs >= _totalMs;
+        if (done)
+            for (size_t i = 0; i < _shown.size(); ++i)
+                Book(i, _totalMs);
+        _trace.wallUs += (uint64)std::chrono::duration_cast<std::chrono::microseconds>(SliceClock::now() - start).count();
+        return done;
+    }
+
+    SimTrace const& Trace() const { return _trace; }
+
+private:
+    void Tick()
+    {
+        uint64 wallMs = _startMs + _simMs;
+        int minute = int((wallMs / 60000u) % kMinutesPerDay);
+        int yday = int((_lt.tm_yday + wallMs / 86400000u) % 365);
+
+        int key = RangesKeyAt(minute);
+        if (key != _rangesKey)
+        {
+            BlendRangesForKey(key, _ranges);
+            _rangesKey = key;
+        }
+        _ctx.cellIndex = CellIndex(SeasonForYearDay(yday), DayPartAt(minute));
+
+        g_EngineNowMs += _trace.tickMs;
+        ProcessDueSprinkleExpiry();
+        ProcessDueFronts(_ctx.cellIndex, _ctx.diffMs);
+        ProcessDueRegions(_ctx.cellIndex, _ctx.diffMs);
+        WakeAllOnContextChange(_watch, _ctx);
+
+        RunDueZones(_ctx, [&](uint32 zone, WeatherState state, float)
+        {
+            auto row = _rowOf.find(zone);
+            if (row == _rowOf.end())
+                return;
+            size_t i = row->second;
+            ++_trace.pushes[i];
+            if (state != _shown[i])
+            {
+                ++_trace.changes[i];
+                Book(i, _simMs);
+                _shown[i] = state;
+            }
+        });
+    }
+
+    // time in state is booked when the shown state changes (and once at the end)
+    void Book(size_t i, uint64 simMs)
+    {
+        size_t idx = StateIndex(_shown[i]);
+        if (idx != kStateCount)
+            _trace.stateMs[idx][i] += simMs - _shownSince[i];
+        _shownSince[i] = simMs;
+    }
+
+    EngineState _state;
+    SimTrace _trace;
+    tm _lt;
+    uint64 _startMs = 0;
+    uint64 _totalMs = 0;
+    uint64 _simMs = 0;
+    Range _ranges[kStateCount];
+    int _rangesKey = -1;
+    TickContext _ctx;
+    ContextWatch _watch;
+    std::unordered_map<uint32, size_t> _rowOf;
+    std::vector<WeatherState> _shown;
+    std::vector<uint64> _shownSince;
+};
+
+// TSV: one row per zone, time share (%) per state as columns.
+static bool WriteSimTrace(SimTrace const& trace, std::string const& path)
+{
+    std::ofstream out(path, std::ios::trunc);
+    if (!out)
+        return false;
+
+    out << "# WeatherVibe simulation days=" << trace.days << " tickMs=" << trace.tickMs << " seed=" << trace.seed
+        << " zones=" << trace.zones.size() << "\n";
+    out << "zone\tprofile\tpushes\tchanges";
+    for (WeatherState s : kAcceptedStates)
+        out << "\t" << WeatherStateName(s);
+    out << "\n" << std::fixed << std::setprecision(2);
+
+    double const totalMs = double(trace.days) * 86400000.0;
+    for (size_t i = 0; i < trace.zones.size(); ++i)
+    {
+        out << trace.zones[i] << "\t" << trace.profiles[i] << "\t" << trace.pushes[i] << "\t" << trace.changes[i];
+        for (size_t s = 0; s < kStateCount; ++s)
+            out << "\t" << (totalMs > 0.0 ? 100.0 * double(trace.stateMs[s][i]) / totalMs : 0.0);
+        out << "\n";
+    }
+    return bool(out);
+}
+
+// ======================================
+// Synthetic load (recording sink + scratch player tracking)
+// ======================================
+constexpr uint32 kMaxLoadPlayers = 100000;
+constexpr uint32 kMaxLoadTicks = 100000;
+constexpr uint32 kLoadGuidBase = 0xF0000000u; // synthetic guid lows, far above real characters
+constexpr uint32 kMaxBenchPlayers = 10000;     // .wvibe bench areas runs in one world update,
+constexpr uint32 kMaxBenchMoves = 100000;      // so it stays within a few tens of ms
+
+// Empty player tracking (area occupancy, online personalized players); swapped in, synthetic players
+// can be filed and moved without touching the live ones.
+struct PlayerTrackingState
+{
+    explicit PlayerTrackingState(size_t areaSlots) : areaPlayers(areaSlots) {}
+
+    void Swap()
+    {
+        std::swap(areaPlayers, g_AreaPlayers);
+        std::swap(playerSeat, g_PlayerAreaSeat);
+        std::swap(occupied, g_AreaOccupiedPerZone);
+        std::swap(personalOnline, g_PersonalizedOnline);
+        std::swap(personalPerZone, g_PersonalizedPerZone);
+    }
+
+    std::vector<std::vector<ObjectGuid>> areaPlayers;
+    std::unordered_map<uint32, AreaSeat> playerSeat;
+    std::unordered_map<uint32, uint32> occupied;
+    std::unordered_map<uint32, uint32> personalOnline;
+    std::unordered_map<uint32, uint32> personalPerZone;
+};
+
+// On top of the scratch tracking: delivery goes to `sink`, snapshots go to a copy of g_LastApplied and
+// synthetic players get their own prefs table. Pair with an EngineState for the zone state.
+struct LoadTestState
+{
+    explicit LoadTestState(WeatherSink& sink) : tracking(g_AreaControllers.size()), sink(&sink), lastApplied(g_LastApplied) {}
+
+    void Swap()
+    {
+        tracking.Swap();
+        std::swap(sink, g_Sink);
+        std::swap(lastApplied, g_LastApplied);
+        std::swap(prefs, g_PlayerPrefs);
+    }
+
+    PlayerTrackingState tracking;
+    WeatherSink* sink;
+    LastAppliedStore lastApplied;
+    std::unordered_map<uint32, PlayerPrefs> prefs;
+};
+
+struct LoadPhase
+{
+    uint64 wallUs = 0;
+    RecordingSink::Counters sent;
+};
+
+struct LoadReport
+{
+    uint32 players = 0;
+    uint32 ticks = 0;
+    uint32 spots = 0;
+    LoadPhase storm; // every synthetic player logs in
+    LoadPhase ticking;
+    std::vector<std::pair<uint32, RecordingSink::Counters>> topZones; // by bytes, during ticks
+};
+
+// Logs `players` synthetic players into the auto zones and controlled areas (one in ten with personal
+// settings when those are enabled), then runs `ticks` engine ticks at WeatherVibe.Auto.TickMs under the
+// current season/day part. Nothing reaches real clients. Step advances it until a deadline with its
+// private state swapped in, so a big run spreads over world updates; phase times count only the time
+// spent in them.
+class LoadRun
+{
+public:
+    LoadRun(uint32 players, uint32 ticks, uint32 seed) : _engine(EngineState::CopyOfLive(seed)), _scratch(_sink), _rng(seed)
+    {
+        _report.players = players;
+        _report.ticks = ticks;
+        std::copy(ActiveRanges(), ActiveRanges() + kStateCount, _ranges.begin());
+        _ctx = MakeTickContext(g_AutoTickMs, _ranges.data(), CellIndex(GetCurrentSeason(), GetCurrentDayPart()));
+
+        // where players stand: (zone, area) for every enabled zone controller and its children, and every controlled area
+        for (auto const& [controller, az] : _engine.zones)
+        {
+            if (!az.enabled || AreaSlotOf(controller))
+                continue;
+            _spots.emplace_back(controller, controller);
+            if (auto itc = g_ZoneChildren.find(controller); itc != g_ZoneChildren.end())
+                for (uint32 child : itc->second)
+                    _spots.emplace_back(child, child);
+        }
+        for (size_t slot = 1; slot < g_AreaControllers.size(); ++slot)
+            _spots.emplace_back(g_AreaControllers[slot].zone, g_AreaControllers[slot].area);
+        std::sort(_spots.begin(), _spots.end());
+        _report.spots = (uint32)_spots.size();
+        _roster.reserve(_spots.empty() ? 0 : players);
+    }
+
+    LoadRun(LoadRun const&) = delete;
+    LoadRun& operator=(LoadRun const&) = delete;
+
+    // Returns true once the run is over (at once when there is nowhere to place players).
+    bool Step(SliceClock::time_point deadline)
+    {
+        if (_spots.empty())
+            return true;
+
+        SwapScope<EngineState> engine(_engine);
+        SwapScope<LoadTestState> scratch(_scratch);
+        // players are cheap, so the clock is read every 64 of them; a tick can cost a millisecond
+        uint32 n = 0;
+        auto expired = [&](uint32 stride) { return ++n % stride == 0 && SliceClock::now() >= deadline; };
+        auto us = [](SliceClock::time_point since) { return (uint64)std::chrono::duration_cast<std::chrono::microseconds>(SliceClock::now() - since).count(); };
+
+        while (_roster.size() < _report.players)
+        {
+            ObjectGuid guid = ObjectGuid::Create<HighGuid::Player>(kLoadGuidBase + (uint32)_roster.size());
+            _roster.emplace_back(guid, _spots[_rng() % _spots.size()]);
+            if (g_PersonalEnabled && _rng() % 10 == 0)
+            {
+                PlayerPrefs& prefs = g_PlayerPrefs[guid.GetCounter()];
+                prefs.maxPct = uint8(25 + _rng() % 76);
+                if (_rng() % 2)
+                    prefs.blocked = uint16(1u << (_rng() % kStateCount));
+            }
+            _sink.Join(guid, _roster.back().second.first);
+            if (expired(64))
+                return false;
+        }
+
+        if (_arrived < _roster.size())
+        {
+            auto t0 = SliceClock::now();
+            while (_arrived < _roster.size())
+            {
+                auto const& [guid, spot] = _roster[_arrived++];
+                PlayerArrived(WeatherRecipient{ guid, nullptr }, spot.first, spot.second);
+                if (expired(64))
+                    break;
+            }
+            _report.storm.wallUs += us(t0);
+            if (_arrived < _roster.size())
+                return false;
+            _report.storm.sent = _sink.Total();
+            _sink.ResetCounters();
+        }
+
+        auto t0 = SliceClock::now();
+        while (_ticked < _report.ticks)
+        {
+            ++_ticked;
+            g_EngineNowMs += _ctx.diffMs;
+            ProcessDueSprinkleExpiry();
+            ProcessDueFronts(_ctx.cellIndex, _ctx.diffMs);
+            ProcessDueRegions(_ctx.cellIndex, _ctx.diffMs);
+            WakeAllOnContextChange(_watch, _ctx);
+            RunDueZones(_ctx, [](uint32 zone, WeatherState state, float norm) { PushWeatherToClient(zone, state, norm); });
+            if (expired(1))
+                break;
+        }
+        _report.ticking.wallUs += us(t0);
+        if (_ticked < _report.ticks)
+            return false;
+
+        _report.ticking.sent = _sink.Total();
+        _report.topZones.assign(_sink.PerZone().begin(), _sink.PerZone().end());
+        std::sort(_report.topZones.begin(), _report.topZones.end(),
+            [](auto const& a, auto const& b) { return a.second.bytes != b.second.bytes ? a.second.bytes > b.second.bytes : a.first < b.first; });
+        if (_report.topZones.size() > 5)
+            _report.topZones.resize(5);
+        return true;
+    }
+
+    LoadReport const& Report() const { return _report; }
+
+private:
+    EngineState _engine;
+    RecordingSink _sink;
+    LoadTestState _scratch;
+    LoadReport _report;
+    std::mt19937 _rng;
+    std::vector<std::pair<uint32, uint32>> _spots;
+    std::vector<std::pair<ObjectGuid, std::pair<uint32, uint32>>> _roster;
+    size_t _arrived = 0;
+    uint32 _ticked = 0;
+    std::array<Range, kStateCount> _ranges;
+    TickContext _ctx;
+    ContextWatch _watch;
+};
+
+// ======================================
+// Self-test (engine math properties + differential engine check)
+// ======================================
+constexpr uint32 kMaxSelfTestTicks = 50000000;
+
+// Streams its arguments into one string (failure descriptions).
+template <typename... Args>
+static std::string Describe(Args const&... args)
+{
+    std::ostringstream oss;
+    (oss << ... << args);
+    return oss.str();
+}
+
+struct SelfTest
+{
+    explicit SelfTest(char const* name) : suite(name) {}
+
+    char const* suite;
+    uint64 checks = 0;
+    uint64 failures = 0;
+    std::vector<std::string> notes; // first few failures, described
+
+    // describe() only runs on failure, so passing checks cost no formatting
+    template <typename Describe>
+    void Expect(bool ok, Describe&& describe)
+    {
+        ++checks;
+        if (ok)
+            return;
+        ++failures;
+        if (notes.size() < 4)
+            notes.push_back(describe());
+    }
+};
+
+// Percent <-> raw over every daypart row plus random tables: bounds, round trip, monotonicity, clamping.
+static void SelfTestMapping(SelfTest& t, std::mt19937& rng)
+{
+    std::vector<std::array<Range, kStateCount>> tables;
+    for (size_t dp = 0; dp < (size_t)DayPart::COUNT; ++dp)
+        tables.emplace_back(std::to_array(g_StateRanges[dp]));
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (int i = 0; i < 64; ++i)
+    {
+        std::array<Range, kStateCount>& tbl = tables.emplace_back();
+        for (Range& r : tbl)
+        {
+            r.min = unit(rng);
+            r.max = (i % 8 == 0) ? r.min : unit(rng); // some degenerate bands
+            if (r.max < r.min) std::swap(r.min, r.max);
+        }
+    }
+
+    for (auto const& tbl : tables)
+        for (size_t s = 0; s < kStateCount; ++s)
+        {
+            WeatherState const state = kAcceptedStates[s];
+            Range const r = tbl[s];
+            float const span = r.max - r.min;
+            float const tol = 1e-5f / std::max(span, 1e-3f);
+            float prevRaw = -1.0f, prevPct = -1.0f;
+            for (int k = 0; k <= 1000; ++k)
+            {
+                float const p = k / 1000.0f;
+                float const raw = MapPercentToRawGrade(tbl.data(), state, p);
+                t.Expect(raw >= r.min && raw <= r.max + 1e-6f, [&] { return Describe("map ", WeatherStateName(state), " ", p, " -> ", raw, " outside [", r.min, ", ", r.max, "]"); });
+                t.Expect(raw >= prevRaw, [&] { return Describe("map ", WeatherStateName(state), " not monotone at ", p); });
+                prevRaw = raw;
+
+                float const back = RawToPercent01(tbl.data(), state, raw);
+                if (span > 0.0f)
+                    t.Expect(std::fabs(back - p) <= tol, [&] { return Describe("round trip ", WeatherStateName(state), " ", p, " -> ", raw, " -> ", back, " on [", r.min, ", ", r.max, "]"); });
+                else
+                    t.Expect(back == 0.0f, [&] { return Describe("degenerate band ", WeatherStateName(state), " gave ", back); });
+
+                float const pct = RawToPercent01(tbl.data(), state, p); // p read as a raw grade
+                t.Expect(pct >= 0.0f && pct <= 1.0f && pct >= prevPct, [&] { return Describe("raw->pct ", WeatherStateName(state), " at ", p, " = ", pct); });
+                prevPct = pct;
+            }
+            t.Expect(MapPercentToRawGrade(tbl.data(), state, -0.5f) == MapPercentToRawGrade(tbl.data(), state, 0.0f)
+                && MapPercentToRawGrade(tbl.data(), state, 1.5f) == MapPercentToRawGrade(tbl.data(), state, 1.0f),
+                [&] { return Describe("map ", WeatherStateName(state), " does not clamp percent"); });
+        }
+}
+
+// Core bounds: every output is a grade the client accepts, the clamp is idempotent and monotone; the
+// same for the visual levels.
+static void SelfTestCoreBounds(SelfTest& t)
+{
+    for (WeatherState state : kAcceptedStates)
+    {
+        float const lo = state == WEATHER_STATE_FINE ? 0.0f : kMinGrade;
+        float prev = -1.0f;
+        for (int k = -2000; k <= 4000; ++k)
+        {
+            float const g = k / 2000.0f;
+            float const c = ClampToCoreBounds(g, state);
+            t.Expect(c >= lo && c <= kMaxGrade, [&] { return Describe("clamp ", WeatherStateName(state), " ", g, " -> ", c, " outside [", lo, ", ", kMaxGrade, "]"); });
+            t.Expect(ClampToCoreBounds(c, state) == c, [&] { return Describe("clamp ", WeatherStateName(state), " not idempotent at ", g); });
+            t.Expect(c >= prev, [&] { return Describe("clamp ", WeatherStateName(state), " not monotone at ", g); });
+            prev = c;
+        }
+
+        // visual levels: snapping is monotone and idempotent, and every level hits its prebuilt packet
+        float prevQ = -1.0f;
+        for (int k = 0; k <= 2000; ++k)
+        {
+            float const g = ClampToCoreBounds(k / 2000.0f, state);
+            float const q = QuantizeGrade(state, g);
+            t.Expect(q >= prevQ && QuantizeGrade(state, q) == q, [&] { return Describe("quantize ", WeatherStateName(state), " at ", g, " -> ", q); });
+            prevQ = q;
+        }
+        size_t const idx = StateIndex(state);
+        for (float grade : g_Quant[idx].grades)
+            t.Expect(QuantizedPacket(state, grade) != nullptr, [&] { return Describe("no cached packet for ", WeatherStateName(state), " level ", grade); });
+    }
+}
+
+// Every compiled alias table (profile cells and transition rows) spreads exactly its weights' mass.
+static void SelfTestSamplers(SelfTest& t)
+{
+    auto check = [&](std::string const& where, std::array<uint32, kStateCount> const& weights, StateSampler const& s)
+    {
+        uint64 total = 0;
+        for (uint32 w : weights) total += w;
+        t.Expect(s.empty == (total == 0), [&] { return Describe(where, " empty=", s.empty, " with total weight ", total); });
+        if (!total || s.empty)
+            return;
+
+        std::array<double, kStateCount> mass{};
+        for (size_t i = 0; i < kStateCount; ++i)
+        {
+            mass[i] += s.prob[i] / double(kStateCount);
+            mass[s.alias[i]] += (1.0 - s.prob[i]) / double(kStateCount);
+        }
+        for (size_t i = 0; i < kStateCount; ++i)
+        {
+            double const want = double(weights[i]) / double(total);
+            t.Expect(std::fabs(mass[i] - want) < 1e-5, [&] { return Describe(where, " ", WeatherStateName(kAcceptedStates[i]), " mass ", mass[i], " != ", want); });
+        }
+    };
+
+    for (auto const& [name, p] : g_Profiles)
+        for (size_t c = 0; c < kProfileCells; ++c)
+            check(Describe("profile ", p->name, " cell ", c), p->cells[c].weights, p->cells[c].sampler);
+    for (size_t n = 0; n < g_Transitions.size(); ++n)
+        for (size_t i = 0; i < kStateCount; ++i)
+            check(Describe("transitions ", n + 1, " after ", WeatherStateName(kAcceptedStates[i])), g_Transitions[n].weights[i], g_Transitions[n].rows[i]);
+}
+
+// HH:MM parsing, start validation and the daypart of every minute, under random start sets.
+static void SelfTestDayParts(SelfTest& t, std::mt19937& rng)
+{
+    for (int m = 0; m < kMinutesPerDay; ++m)
+    {
+        std::string text = Describe(std::setw(2), std::setfill('0'), m / 60, ":", std::setw(2), std::setfill('0'), m % 60);
+        t.Expect(ParseHHMM(text, -1) == m, [&] { return Describe("ParseHHMM('", text, "') != ", m); });
+    }
+    for (int h = 0; h < 24; ++h)
+        t.Expect(ParseHHMM(std::to_string(h), -1) == h * 60, [&] { return Describe("ParseHHMM('", h, "') != ", h * 60); });
+    for (char const* bad : { "", "24:00", "12:60", "-1:00", "ab", "12:", ":30", "1:2:3", "99" })
+        t.Expect(ParseHHMM(bad, -1) == -1, [&] { return Describe("ParseHHMM('", bad, "') accepted"); });
+
+    DayPartStarts const savedStarts = g_Starts;
+    uint32 const savedBlend = g_BlendMinutes;
+    auto const savedTable = g_DayBlend;
+
+    std::uniform_int_distribution<int> minute(-120, kMinutesPerDay + 120);
+    for (int run = 0; run < 256; ++run)
+    {
+        if (run == 0)
+            g_Starts = savedStarts;
+        else if (run == 1)
+            g_Starts = DayPartStarts{ kMinutesPerDay - 1, kMinutesPerDay - 1, kMinutesPerDay - 1, kMinutesPerDay - 1 };
+        else
+            g_Starts = DayPartStarts{ minute(rng), minute(rng), minute(rng), minute(rng) };
+        ValidateDayPartStarts(g_Starts);
+
+        int const starts[] = { g_Starts.morning, g_Starts.afternoon, g_Starts.evening, g_Starts.night };
+        t.Expect(starts[0] >= 0 && starts[0] < starts[1] && starts[1] < starts[2] && starts[2] < starts[3] && starts[3] < kMinutesPerDay,
+            [&] { return Describe("starts ", starts[0], " ", starts[1], " ", starts[2], " ", starts[3], " not ordered within the day"); });
+
+        // reference: the last start at or before the minute, wrapping to night before the morning
+        std::array<uint32, (size_t)DayPart::COUNT> minutesIn{};
+        for (int m = 0; m < kMinutesPerDay; ++m)
+        {
+            DayPart ref = DayPart::NIGHT;
+            for (size_t i = 0; i < 4; ++i)
+                if (m >= starts[i])
+                    ref = DayPart(i);
+            DayPart const got = DayPartForMinute(m);
+            t.Expect(got == ref, [&] { return Describe("minute ", m, " -> ", DayPartName(got), " (expected ", DayPartName(ref), ")"); });
+            ++minutesIn[(size_t)got];
+        }
+        for (size_t i = 0; i < 4; ++i)
+            t.Expect(minutesIn[i] > 0, [&] { return Describe(DayPartName(DayPart(i)), " never selected (starts ", starts[0], " ", starts[1], " ", starts[2], " ", starts[3], ")"); });
+
+        // blend table: each minute blends between its own daypart and a neighbour, never further
+        g_BlendMinutes = run % 4 == 0 ? 0 : rng() % 240;
+        BuildDayBlendTable(g_Tables);
+        for (int m = 0; m < kMinutesPerDay; ++m)
+        {
+            MinuteBlend const& b = g_DayBlend[m];
+            DayPart const own = DayPartForMinute(m);
+            bool ok = b.t >= 0.0f && b.t < 1.0f && (b.from == own || b.to == own)
+                && (b.from == b.to ? b.t == 0.0f : b.to == DayPart(((size_t)b.from + 1) % 4));
+            t.Expect(ok, [&] { return Describe("blend at minute ", m, ": ", DayPartName(b.from), " -> ", DayPartName(b.to), " t=", b.t, " (own ", DayPartName(own), ")"); });
+        }
+    }
+
+    g_Starts = savedStarts;
+    g_BlendMinutes = savedBlend;
+    g_DayBlend = savedTable;
+    g_ActiveRangesKey = -1;
+}
+
+// Easing tables against the exact curves, and the closed-form tween between its endpoints.
+static void SelfTestTween(SelfTest& t, std::mt19937& rng)
+{
+    for (size_t c = 0; c < (size_t)TweenCurve::COUNT; ++c)
+    {
+        TweenCurve const curve = TweenCurve(c);
+        float prev = -1.0f;
+        for (int k = 0; k <= 4096; ++k)
+        {
+            float const x = k / 4096.0f;
+            float const u = 2.0f - 2.0f * x;
+            float const exact = curve == TweenCurve::LINEAR ? x
+                : curve == TweenCurve::SMOOTHSTEP ? x * x * (3.0f - 2.0f * x)
+                : x < 0.5f ? 4.0f * x * x * x : 1.0f - u * u * u / 2.0f;
+            float const e = EaseAt(curve, x);
+            t.Expect(std::fabs(e - exact) <= 5e-5f, [&] { return Describe("ease ", TweenCurveName(curve), " at ", x, " = ", e, " (exact ", exact, ")"); });
+            t.Expect(e >= prev, [&] { return Describe("ease ", TweenCurveName(curve), " not monotone at ", x); });
+            prev = e;
+        }
+        t.Expect(EaseAt(curve, 0.0f) == 0.0f && EaseAt(curve, 1.0f) == 1.0f && EaseAt(curve, -1.0f) == 0.0f && EaseAt(curve, 2.0f) == 1.0f,
+            [&] { return Describe("ease ", TweenCurveName(curve), " endpoints"); });
+    }
+
+    std::uniform_real_distribution<float> pct(0.0f, 100.0f);
+    for (int i = 0; i < 2000; ++i)
+    {
+        AutoZone az;
+        az.tweenFromPct = pct(rng);
+        az.tgtPct = pct(rng);
+        az.tweenStartMs = rng() % 1000000;
+        az.tweenMs = i % 16 == 0 ? 0 : 1 + rng() % 600000;
+        float const lo = std::min(az.tweenFromPct, az.tgtPct), hi = std::max(az.tweenFromPct, az.tgtPct);
+        uint64 const endMs = az.tweenStartMs + az.tweenMs;
+        if (az.tweenMs)
+            t.Expect(TweenPctAt(az, az.tweenStartMs) == az.tweenFromPct, [&] { return Describe("tween start ", TweenPctAt(az, az.tweenStartMs), " != ", az.tweenFromPct); });
+        t.Expect(TweenPctAt(az, endMs) == az.tgtPct && TweenPctAt(az, endMs + 1000) == az.tgtPct,
+            [&] { return Describe("tween end ", TweenPctAt(az, endMs), " != ", az.tgtPct); });
+        for (int k = 0; k <= 32; ++k)
+        {
+            float const v = TweenPctAt(az, az.tweenStartMs + az.tweenMs * k / 32);
+            t.Expect(v >= lo - 1e-3f && v <= hi + 1e-3f, [&] { return Describe("tween ", v, " outside [", lo, ", ", hi, "]"); });
+        }
+    }
+}
+
+// One packet the engine decided to send, stamped with its tick.
+struct EmittedPacket
+{
+    uint32 tick;
+    WeatherState state;
+    float norm;
+
+    bool operator==(EmittedPacket const&) const = default;
+};
+
+// A timeline on an auto zone with the auto engine off, on a private engine state: each step goes out on
+// the tick it starts, nothing else is sent, and the zone falls silent once the timeline ends.
+static void SelfTestTimelines(SelfTest& t, std::mt19937& rng)
+{
+    std::vector<uint32> zones;
+    for (auto const& [zone, az] : g_AutoZones)
+        if (az.enabled)
+            zones.push_back(zone);
+    std::sort(zones.begin(), zones.end());
+    if (zones.empty())
+    {
+        t.notes.push_back("timelines skipped: no enabled auto zones");
+        return;
+    }
+
+    EngineState state = EngineState::CopyOfLive(rng());
+    SwapScope<EngineState> sim(state);
+    uint32 const zone = zones[rng() % zones.size()];
+    AutoZone& az = g_AutoZones[zone];
+    az.sprinkles = SprinkleStack{};
+
+    // two steps, each a state change from what is shown before it, so both must go out
+    size_t const first = (StateIndex(az.lastStateSent) + 1 + rng() % (kStateCount - 1)) % kStateCount;
+    size_t const second = (first + 1 + rng() % (kStateCount - 1)) % kStateCount;
+    Timeline tl;
+    tl.name = "selftest";
+    tl.zones = { zone };
+    tl.steps = { { kAcceptedStates[first], float(rng() % 101), 3000 }, { kAcceptedStates[second], float(rng() % 101), 5000 } };
+
+    std::vector<Timeline> timelines{ tl };
+    std::swap(timelines, g_Timelines);
+    bool const savedAuto = g_AutoEnabled;
+    g_AutoEnabled = false;
+
+    StartTimeline(0);
+    ContextWatch watch;
+    std::vector<EmittedPacket> got;
+    uint32 others = 0;
+    for (uint32 tick = 0; tick < 12; ++tick)
+        RunEngineTick(1000, watch, [&](uint32 z, WeatherState s, float norm) { if (z == zone) got.push_back({ tick, s, norm }); else ++others; });
+
+    g_AutoEnabled = savedAuto;
+    std::swap(timelines, g_Timelines);
+
+    bool const stepsOut = got.size() == 2 && got[0].tick == 0 && got[0].state == kAcceptedStates[first]
+        && got[1].tick == 3 && got[1].state == kAcceptedStates[second];
+    t.Expect(stepsOut, [&]
+    {
+        std::string sent;
+        for (EmittedPacket const& p : got)
+            sent += Describe(" tick ", p.tick, " ", WeatherStateName(p.state));
+        return Describe("zone ", zone, " with auto off sent", sent.empty() ? " nothing" : sent, ", want steps at ticks 0 and 3");
+    });
+    t.Expect(others == 0, [&] { return Describe(others, " packet(s) to zones outside the timeline with auto off"); });
+}
+
+// Frozen reference for the differential suite: one zone stepped on every tick, in the shape of the
+// original per-tick loop, with only the semantics changes documented since: eased closed-form tweens
+// from the percent shown on the previous tick (absolute window ends), transition rows, a per-tick
+// packet budget and quantized grades. It shares only the sampling and percent->raw primitives with
+// the engine (the other suites check those); sprinkles, tweens, snapping and the filter are its own.
+struct ReferenceSprinkle
+{
+    uint32 seq;        // push order: newest wins among equal priorities
+    uint8 priority;
+    WeatherState state;
+    float pct;
+    std::string tag;
+    uint64 expireMs;
+};
+
+struct ReferenceZone
+{
+    Profile const* profile = nullptr;
+    WeatherState curState = WEATHER_STATE_FINE;
+    WeatherState tgtState = WEATHER_STATE_FINE;
+    float tgtPct = 0.0f;
+    float fromPct = 0.0f;
+    uint64 tweenStartMs = 0;
+    uint64 tweenMs = 0;
+    uint64 windowEndMs = 0;
+    float lastRawSent = -1.0f;
+    WeatherState lastStateSent = WEATHER_STATE_FINE;
+    float nudge = 0.0f;
+    float sendRate = 0.0f;
+    uint64 lastSendMs = 0;
+    std::vector<ReferenceSprinkle> sprinkles;
+    uint32 nextSeq = 0;
+};
+
+static float ReferenceTweenPct(ReferenceZone const& z, uint64 atMs)
+{
+    if (!z.tweenMs || atMs >= z.tweenStartMs + z.tweenMs)
+        return z.tgtPct;
+    if (atMs <= z.tweenStartMs)
+        return z.fromPct;
+    return z.fromPct + (z.tgtPct - z.fromPct) * EaseAt(g_TweenCurve, float(atMs - z.tweenStartMs) / float(z.tweenMs));
+}
+
+// Visual levels sit on the grid lo + i * step; a grade snaps to the nearest, halfway rounds up.
+static float ReferenceGrade(Range const* ranges, WeatherState state, float pct)
+{
+    float grade = ClampToCoreBounds(MapPercentToRawGrade(ranges, state, pct / 100.0f), state);
+    size_t idx = StateIndex(state);
+    if (idx == kStateCount || g_Quant[idx].grades.empty())
+        return grade;
+    QuantTable const& q = g_Quant[idx];
+    if (q.step <= 0.0f)
+        return q.grades[0];
+    float const steps = (grade - q.lo) / q.step;
+    double const level = std::floor(double(steps) + 0.5);
+    return q.grades[(size_t)std::clamp(level, 0.0, double(q.grades.size() - 1))];
+}
+
+static bool ReferencePushSprinkle(ReferenceZone& z, ReferenceSprinkle s)
+{
+    std::erase_if(z.sprinkles, [&](ReferenceSprinkle const& o) { return o.tag == s.tag; });
+    if (z.sprinkles.size() == kSprinkleSlots)
+    {
+        // the weakest: lowest priority, oldest among equals
+        auto weakest = std::min_element(z.sprinkles.begin(), z.sprinkles.end(), [](ReferenceSprinkle const& a, ReferenceSprinkle const& b)
+            { return a.priority != b.priority ? a.priority < b.priority : a.seq < b.seq; });
+        if (s.priority < weakest->priority)
+            return false;
+        z.sprinkles.erase(weakest);
+    }
+    s.seq = z.nextSeq++;
+    z.sprinkles.push_back(std::move(s));
+    return true;
+}
+
+static bool ReferenceStep(ReferenceZone& z, TickContext const& ctx, WeatherState& outState, float& outNorm)
+{
+    uint64 const now = g_EngineNowMs;
+    std::erase_if(z.sprinkles, [&](ReferenceSprinkle const& s) { return s.expireMs <= now; });
+
+    if (now >= z.windowEndMs)
+    {
+        float const shown = ReferenceTweenPct(z, now - std::min<uint64>(ctx.diffMs, now));
+        float pct = 0.0f;
+        z.tgtState = WEATHER_STATE_FINE;
+        if (z.profile)
+        {
+            ProfileCell const& cell = z.profile->cells[ctx.cellIndex];
+            z.tgtState = PickNextState(*z.profile, cell, z.curState);
+            pct = RandPercentBetween(cell);
+        }
+        z.windowEndMs = now + RandWindowMs();
+        z.fromPct = shown;
+        z.tgtPct = pct;
+        z.tweenStartMs = now;
+        z.tweenMs = g_TweenSec * 1000u;
+    }
+    z.curState = z.tgtState;
+    float const curPct = ReferenceTweenPct(z, now);
+    bool const tweening = z.tweenMs && now < z.tweenStartMs + z.tweenMs;
+
+    outState = z.curState;
+    float outPct = curPct;
+    auto top = std::max_element(z.sprinkles.begin(), z.sprinkles.end(), [](ReferenceSprinkle const& a, ReferenceSprinkle const& b)
+        { return a.priority != b.priority ? a.priority < b.priority : a.seq < b.seq; });
+    if (top != z.sprinkles.end()) { outState = top->state; outPct = top->pct; }
+    outNorm = ReferenceGrade(ctx.ranges, outState, outPct);
+
+    float const delta = z.lastRawSent < 0.0f ? 1.0f : std::fabs(outNorm - z.lastRawSent);
+    bool send = outState != z.lastStateSent;
+    if (!send && g_PacketBudget > 0.0f)
+        send = delta >= z.nudge && now - z.lastSendMs >= g_MinSendIntervalMs;
+    else if (!send)
+        send = delta >= g_TinyNudge;
+
+    // the rate EWMA is kept as of the last send and decays in closed form from there
+    auto rateNow = [&] { return z.sendRate * std::exp(-float(now - z.lastSendMs) / (g_RateWindowSec * 1000.0f)); };
+    if (send)
+    {
+        z.sendRate = rateNow() + ctx.rateAlpha * 60000.0f / (float)ctx.diffMs;
+        z.lastSendMs = now;
+    }
+    if (g_PacketBudget > 0.0f)
+    {
+        float const rate = rateNow();
+        if (rate > g_PacketBudget)
+            z.nudge = std::min(z.nudge * 1.10f, g_NudgeMax);
+        else if (tweening && rate < 0.5f * g_PacketBudget)
+            z.nudge = std::max(z.nudge * 0.95f, g_NudgeMin);
+    }
+
+    if (!send)
+        return false;
+    z.lastRawSent = outNorm;
+    z.lastStateSent = outState;
+    return true;
+}
+
+// Drives one zone for `ticks` ticks with random sprinkles, unsprinkles and context changes (the same
+// sequence for a given seed), through the event-driven engine or the reference.
+static void RunEngineForDiff(uint32 zone, uint32 diffMs, uint32 ticks, uint32 seed, bool reference, std::vector<EmittedPacket>& out)
+{
+    EngineState state = EngineState::CopyOfLive(seed);
+    SwapScope<EngineState> sim(state);
+    for (auto it = g_AutoZones.begin(); it != g_AutoZones.end();)
+        it = it->first == zone ? std::next(it) : g_AutoZones.erase(it);
+    g_Regions.clear();
+    g_RegionOrders.Clear();
+    g_SprinkleExpiry.Clear();
+    g_Fronts.Clear();
+    AutoZone& az = g_AutoZones[zone];
+    az.region = 0;
+    az.sprinkles = SprinkleStack{};
+
+    ReferenceZone ref;
+    ref.profile = az.effective.get();
+    ref.curState = az.curState;
+    ref.tgtState = az.tgtState;
+    ref.tgtPct = az.tgtPct;
+    ref.fromPct = az.tweenFromPct;
+    ref.tweenStartMs = az.tweenStartMs;
+    ref.tweenMs = az.tweenMs;
+    ref.windowEndMs = az.windowEndMs;
+    ref.lastRawSent = az.lastRawSent;
+    ref.lastStateSent = az.lastStateSent;
+    ref.nudge = az.nudge;
+    ref.sendRate = az.sendRate;
+    ref.lastSendMs = az.lastSendMs;
+
+    std::mt19937 ev(seed ^ 0x9E3779B9u);
+    std::array<Range, kStateCount> ranges = std::to_array(g_StateRanges[ev() % (size_t)DayPart::COUNT]);
+    TickContext ctx = MakeTickContext(diffMs, ranges.data(), ev() % kProfileCells);
+    ContextWatch watch;
+    out.clear();
+
+    for (uint32 tick = 0; tick < ticks; ++tick)
+    {
+        uint32 const roll = ev() % 4096;
+        if (roll < 2)
+        {
+            Sprinkle sp;
+            sp.id = g_NextSprinkleId++;
+            sp.priority = uint8(ev() % 3);
+            sp.state = kAcceptedStates[ev() % kStateCount];
+            sp.pct = float(ev() % 101);
+            sp.tag = roll ? "a" : "b";
+            uint64 const durMs = uint64(1 + ev() % 900) * 1000u;
+            if (reference)
+                ReferencePushSprinkle(ref, { 0, sp.priority, sp.state, sp.pct, sp.tag, g_EngineNowMs + durMs });
+            else if (az.sprinkles.Push(sp))
+            {
+                g_SprinkleExpiry.Push(g_EngineNowMs + durMs, { zone, sp.id });
+                ScheduleZoneWake(zone, az, g_EngineNowMs);
+            }
+        }
+        else if (roll == 2)
+        {
+            if (reference)
+                ref.sprinkles.clear();
+            else if (az.sprinkles.RemoveTag(""))
+                ScheduleZoneWake(zone, az, g_EngineNowMs);
+        }
+        else if (roll == 3)
+        {
+            // daypart/season change: another profile cell and the bands of another daypart, half blended
+            ctx.cellIndex = ev() % kProfileCells;
+            Range const* row = g_StateRanges[ev() % (size_t)DayPart::COUNT];
+            for (size_t s = 0; s < kStateCount; ++s)
+                ranges[s] = { (ranges[s].min + row[s].min) * 0.5f, (ranges[s].max + row[s].max) * 0.5f };
+        }
+
+        g_EngineNowMs += diffMs;
+        auto emit = [&](uint32, WeatherState state, float norm) { out.push_back({ tick, state, norm }); };
+        if (reference)
+        {
+            WeatherState state;
+            float norm;
+            if (ReferenceStep(ref, ctx, state, norm))
+                emit(zone, state, norm);
+        }
+        else
+        {
+            ProcessDueSprinkleExpiry();
+            ProcessDueFronts(ctx.cellIndex, ctx.diffMs);
+            WakeAllOnContextChange(watch, ctx);
+            RunDueZones(ctx, emit);
+        }
+    }
+}
+
+// The differential splits its ticks into many short runs rather than one long one, so tick lengths,
+// zones and both filter modes all get covered.
+static uint32 DifferentialRuns(uint64 totalTicks)
+{
+    return (uint32)std::clamp<uint64>(totalTicks / 20000, 2, 2000);
+}
+
+// One differential run: the engine (event-driven scheduler, closed-form tweens, sprinkle stack,
+// snapping) against the reference on one live zone, so both consume the shared RNG in the same order.
+// Both must send the same packets on the same ticks; odd runs set a packet budget (adaptive nudge).
+// Returns false (nothing checked) when no auto zone is enabled.
+static bool SelfTestDifferentialRun(SelfTest& t, std::mt19937& rng, uint32 run, uint32 ticks)
+{
+    std::vector<uint32> zones;
+    for (auto const& [zone, az] : g_AutoZones)
+        if (az.enabled)
+            zones.push_back(zone);
+    std::sort(zones.begin(), zones.end());
+    if (zones.empty())
+        return false;
+
+    float const savedBudget = g_PacketBudget;
+    uint32 const savedInterval = g_MinSendIntervalMs;
+    float const testBudget = savedBudget > 0.0f ? savedBudget : 6.0f;
+
+    static constexpr uint32 kDiffs[] = { 250, 1000, 5000 };
+    uint32 const zone = zones[rng() % zones.size()];
+    uint32 const diffMs = kDiffs[rng() % 3];
+    uint32 const seed = rng();
+    bool const budget = run % 2;
+    std::vector<EmittedPacket> expected, actual;
+    g_PacketBudget = budget ? testBudget : 0.0f;
+    g_MinSendIntervalMs = budget ? uint32(60000.0f / testBudget) : 0;
+    RunEngineForDiff(zone, diffMs, ticks, seed, true, expected);
+    RunEngineForDiff(zone, diffMs, ticks, seed, false, actual);
+    g_PacketBudget = savedBudget;
+    g_MinSendIntervalMs = savedInterval;
+
+    auto show = [](auto it, auto end) { return it == end ? std::string("none") : Describe("tick ", it->tick, " ", WeatherStateName(it->state), " ", it->norm); };
+    auto [d, e] = std::mismatch(expected.begin(), expected.end(), actual.begin(), actual.end());
+    t.Expect(d == expected.end() && e == actual.end(), [&]
+    {
+        return Describe("zone ", zone, " tick ", diffMs, " ms seed ", seed, budget ? Describe(" budget ", testBudget) : std::string(),
+            ": packet #", d - expected.begin(), " reference=", show(d, expected.end()), " engine=", show(e, actual.end()));
+    });
+    return true;
+}
+
+// The whole selftest: the property suites, then `ticks` differential ticks. Step works through suites
+// and differential runs until a deadline, so a long differential spreads over world updates (each run
+// copies the live zone it drives when it starts); the reported time counts only the stepping.
+class SelfTestRun
+{
+public:
+    SelfTestRun(uint32 ticks, uint32 seed) : _ticks(ticks), _seed(seed), _rng(seed), _runs(ticks ? DifferentialRuns(ticks) : 0) {}
+
+    // Returns true once every suite and differential run is done.
+    bool Step(SliceClock::time_point deadline)
+    {
+        auto start = SliceClock::now();
+        while (_next < kPropertySuites + _runs)
+        {
+            switch (_next)
+            {
+                case 0: SelfTestMapping(_suites[0], _rng); break;
+                case 1: SelfTestCoreBounds(_suites[1]); break;
+                case 2: SelfTestSamplers(_suites[2]); break;
+                case 3: SelfTestDayParts(_suites[3], _rng); break;
+                case 4: SelfTestTween(_suites[4], _rng); break;
+                case 5: SelfTestTimelines(_suites[5], _rng); break;
+                default:
+                    if (!SelfTestDifferentialRun(_suites[6], _rng, _next - kPropertySuites, std::max<uint32>(_ticks / _runs, 1)))
+                    {
+                        _suites[6].notes.push_back("differential skipped: no enabled auto zones");
+                        _next = kPropertySuites + _runs - 1;
+                    }
+                    break;
+            }
+            ++_next;
+            if (SliceClock::now() >= deadline)
+                break;
+        }
+        _busyUs += (uint64)std::chrono::duration_cast<std::chrono::microseconds>(SliceClock::now() - start).count();
+        return _next >= kPropertySuites + _runs;
+    }
+
+    void Report(ChatHandler* handler) const
+    {
+        uint64 failures = 0;
+        for (SelfTest const& t : _suites)
+        {
+            failures += t.failures;
+            handler->PSendSysMessage("|cff00ff00WeatherVibe:|r selftest %s: %s (%u checks, %u failed)",
+                t.suite, t.failures ? "FAIL" : "ok", (uint32)t.checks, (uint32)t.failures);
+            for (std::string const& note : t.notes)
+                handler->PSendSysMessage("|cff00ff00WeatherVibe:|r   %s", note.c_str());
+        }
+
+        handler->PSendSysMessage("|cff00ff00WeatherVibe:|r selftest %s in %u ms (seed %u, %u differential ticks)",
+            failures ? "FAILED" : "passed", (uint32)(_busyUs / 1000), _seed, _ticks);
+    }
+
+private:
+    static constexpr uint32 kPropertySuites = 6;
+
+    uint32 _ticks;
+    uint32 _seed;
+    std::mt19937 _rng;
+    uint32 _runs;
+    uint32 _next = 0; // property suites first, then differential runs
+    uint64 _busyUs = 0;
+    std::array<SelfTest, 7> _suites{ SelfTest("mapping"), SelfTest("bounds"), SelfTest("samplers"), SelfTest("dayparts"),
+        SelfTest("tween"), SelfTest("timelines"), SelfTest("differential") };
+};
+
+// ======================================
+// Zone selectors (multi-zone commands)
+// ======================================
+constexpr uint32 kMaxSelectorRange = 10000;
+
+// Ids commands may create state for: AreaTable zones/areas, plus anything the config already drives.
+static bool IsKnownZoneId(uint32 id)
+{
+    return sAreaTableStore.LookupEntry(id) || g_AutoZones.count(id);
+}
+
+// "12", "1,12,40", "100-200", "profile:Tundra", "all" (tokens mix freely) -> sorted, deduplicated
+// controller zones; ids the AreaTable does not know are rejected (skipped inside ranges). "all" and "profile:" select from the zones the auto engine knows about.
+static bool ResolveZoneSelector(std::string_view text, std::vector<uint32>& out, std::string& error)
+{
+    out.clear();
+    ForEachToken(text, ',', [&](std::string_view tok, size_t)
+    {
+        if (!error.empty())
+            return;
+
+        std::string lowered;
+        AssignLower(lowered, tok);
+        std::string_view lhs, rhs;
+        uint32 a = 0, b = 0;
+
+        if (lowered == "all")
+        {
+            for (auto const& kv : g_AutoZones)
+                out.push_back(kv.first);
+            for (LastApplied const& la : g_LastApplied.Records())
+                out.push_back(la.zone);
+        }
+        else if (lowered.starts_with("profile:"))
+        {
+            std::string_view name = TrimView(std::string_view(lowered).substr(8));
+            if (!g_Profiles.count(std::string(name)))
+            {
+                error = "unknown profile '" + std::string(name) + "'";
+                return;
+            }
+            for (auto const& kv : g_AutoZones)
+                if (kv.second.enabled && kv.second.profile == name)
+                    out.push_back(kv.first);
+        }
+        else if (SplitPair(tok, '-', lhs, rhs) && ParseUInt(lhs, a) && ParseUInt(rhs, b) && a <= b)
+        {
+            if (b - a >= kMaxSelectorRange)
+            {
+                error = "range '" + std::string(tok) + "' is too wide";
+                return;
+            }
+            for (uint32 z = a; z <= b; ++z)
+                if (IsKnownZoneId(z))
+                    out.push_back(ResolveControllerZone(z));
+        }
+        else if (ParseUInt(tok, a) && a)
+        {
+            if (!IsKnownZoneId(a))
+            {
+                error = "unknown zone or area id " + std::to_string(a);
+                return;
+            }
+            out.push_back(ResolveControllerZone(a));
+        }
+        else
+            error = "bad zone selector '" + std::string(tok) + "'";
+    });
+
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    if (error.empty() && out.empty())
+        error = "selector '" + std::string(text) + "' matches no zones";
+    return error.empty();
+}
+
+static bool ResolveZoneSelector(ChatHandler* handler, std::string_view text, std::vector<uint32>& out)
+{
+    std::string error;
+    if (ResolveZoneSelector(text, out, error))
+        return true;
+    handler->PSendSysMessage("|cff00ff00WeatherVibe:|r %s (use 12 | 1,12 | 100-200 | profile:<name> | all)", error.c_str());
+    return false;
+}
+
+// "12,40,1519" -- at most `limit` ids, then "(+n more)"
+static std::string FormatZoneList(std::vector<uint32> const& zones, size_t limit = 12)
+{
+    std::ostringstream oss;
+    for (size_t i = 0; i < zones.size() && i < limit; ++i)
+        oss << (i ? "," : "") << zones[i];
+    if (zones.size() > limit)
+        oss << " (+" << zones.size() - limit << " more)";
+    return oss.str();
+}
+
+// ======================================
+// Commands
+// ======================================
+// A pending reload installs freshly built zones, tables and timelines over whatever the manual and
+// auto commands change meanwhile (and seeds from a copy of last-applied taken when it started), so
+// those commands refuse until the reload reports back.
+static bool RejectWhileReloading(ChatHandler* handler)
+{
+    if (!g_ReloadPending)
+        return false;
+    handler->SendSysMessage("|cff00ff00WeatherVibe:|r a reload is running; try again once it reports back.");
+    return true;
+}
+
+// Checked before a sim, loadtest or selftest copies the engine state (console runs never queue).
+static bool RejectWhileSlicesFull(ChatHandler* handler)
+{
+    if (!handler->GetPlayer() || g_SlicedCommands.size() < kMaxSlicedCommands)
+        return false;
+    handler->PSendSysMessage("|cff00ff00WeatherVibe:|r %u sims, loadtests or selftests are already queued; try again once one reports back.",
+        (uint32)kMaxSlicedCommands);
+    return true;
+}
+
+// .wvibe set <zones> <state:uint> <percentage:0..100>
+static bool HandleCommandPercent(ChatHandler* handler, std::string zones, uint32 stateVal, float percentage)
+{
+    if (!g_EnableModule)
+    {
+        handler->SendSysMessage("|cff00ff00WeatherVibe:|r module is disabled in config.");
+        return false;
+    }
+    if (RejectWhileReloading(handler))
+        return false;
+    if (!IsValidWeatherState(stateVal))
+    {
+        handler->SendSysMessage("|cff00ff00WeatherVibe:|r Invalid state. Examples: 0=Fine, 1=Fog, 3=LightRain, 4=MediumRain, 5=HeavyRain, 6=LightSnow, 7=MediumSnow, 8=HeavySnow, 22=LightSandstorm, 41=MediumSandstorm, 42=HeavySandstorm, 86=Thunders.");
+        handler->SendSysMessage("Usage: .wvibe set <zones> <state:uint> <percentage:0..100>");
+        return false;
+    }
+
+    std::vector<uint32> controllers;
+    if (!ResolveZoneSelector(handler, zones, controllers))
+        return false;
+
+    float pct01 = std::clamp(percentage, 0.0f, 100.0f) / 100.0f;
+    float raw = MapPercentToRawGrade(ActiveRanges(), static_cast<WeatherState>(stateVal), pct01);
+
+    uint32 delivered = PushWeatherBatch(controllers, (WeatherState)stateVal, raw);
+    for (uint32 controller : controllers)
+        SyncAutoWithManual(controller, (WeatherState)stateVal, raw);
+
+    handler->PSendSysMessage("|cff00ff00WeatherVibe:|r %s %.0f%% (raw %.2f) set on %u zone(s), %u with players: %s", WeatherStateName((WeatherState)stateVal),
+        pct01 * 100.0f, raw, (uint32)controllers.size(), delivered, FormatZoneList(controllers).c_str());
+    return delivered != 0;
+}
+
+// .wvibe setRaw <zones> <state:uint> <raw:0..1>
+static bool HandleCommandRaw(ChatHandler* handler, std::string zones, uint32 stateVal, float grade)
+{
+    if (!g_EnableModule)
+    {
+        handler->SendSysMessage("|cff00ff00WeatherVibe:|r module is disabled in config.");
+        return false;
+    }
+    if (RejectWhileReloading(handler))
+        return false;
+    if (!IsValidWeatherState(stateVal))
+    {
+        handler->SendSysMessage("|cff00ff00WeatherVibe:|r Invalid state. Usage: .wvibe setRaw <zones> <state:uint> <raw:0..1>");
+        return false;
+    }
+
+    std::vector<uint32> controllers;
+    if (!ResolveZoneSelector(handler, zones, controllers))
+        return false;
+
+    float raw = std::clamp(grade, 0.0f, 1.0f);
+    uint32 delivered = PushWeatherBatch(controllers, (WeatherState)stateVal, raw);
+    for (uint32 controller : controllers)
+        SyncAutoWithManual(controller, (WeatherState)stateVal, raw);
+
+    handler->PSendSysMessage("|cff00ff00WeatherVibe:|r %s raw %.2f set on %u zone(s), %u with players: %s", WeatherStateName((WeatherState)stateVal),
+        raw, (uint32)controllers.size(), delivered, FormatZoneList(controllers).c_str());
+    return delivered != 0;
+}
+
+// --- Auto subcommands ---
+static bool HandleAutoOn(ChatHandler* handler)
+{
+    if (RejectWhileReloading(handler))
+        return false;
+    g_AutoEnabled = true;
+    g_LiveContext = ContextWatch{}; // zones idled while auto was off; the next tick wakes them all
+    handler->SendSysMessage("|cff00ff00WeatherVibe:|r auto engine: ON");
+    return true;
+}
+
+static bool HandleAutoOff(ChatHandler* handler)
+{
+    if (RejectWhileReloading(handler))
+        return false;
+    g_AutoEnabled = false;
+    handler->SendSysMessage("|cff00ff00WeatherVibe:|r auto engine: OFF");
+    return true;
+}
+
+// One zone line of `.wvibe auto status`, copied on the world thread and formatted off it.
+struct ZoneStatusRow
+{
+    uint32 zone = 0;
+    uint32 areaZone = 0;        // controlled area: its zone, 0 otherwise
+    uint32 areaPlayers = 0;
+    bool enabled = false;
+    bool hasOverride = false;
+    std::string profile;
+    WeatherState curState = WEATHER_STATE_FINE;
+    WeatherState tgtState = WEATHER_STATE_FINE;
+    float curPct = 0.0f;
+    float tgtPct = 0.0f;
+    uint64 windowMs = 0;
+    uint32 tweenMs = 0;
+    uint64 wakeMs = UINT64_MAX; // UINT64_MAX = no wake queued
+    std::string sprinkle;       // top sprinkle tag
+    uint32 sprinklePriority = 0;
+    uint32 sprinkleCount = 0;   // stacked sprinkles, 0 = none
+    std::string region;
+    std::string timeline;
+};
+
+static bool HandleAutoStatus(ChatHandler* handler)
+{
+    std::ostringstream oss;
+    oss << "Auto=" << (g_AutoEnabled ? "on" : "off")
+        << " tickMs=" << g_AutoTickMs
+        << " window=[" << g_MinWindowSec << "," << g_MaxWindowSec << "]s"
+        << " tween=" << g_TweenSec << "s/" << TweenCurveName(g_TweenCurve)
+        << " quantize=" << (std::any_of(g_Quant.begin(), g_Quant.end(), [](QuantTable const& q) { return !q.grades.empty(); })
+            ? (g_QuantizeLevels ? std::to_string(g_QuantizeLevels) + " levels" : std::string("per state")) : std::string("off"))
+        << " spillover=" << (g_SpillEnabled ? "on" : "off") << "(" << g_SpillNodeZone.size() << " zones, "
+        << g_SpillAdj.size() / 2 << " links, " << g_Fronts.Size() << " pending)"
+        << " regions=" << g_Regions.size() << "(" << g_RegionOrders.Size() << " pending)"
+        << " wakes=" << g_ZoneWakes.Size() + g_NextTickWakes.size()
+        << " season=" << SeasonName(GetCurrentSeason())
+        << " daypart=" << DayPartName(GetCurrentDayPart());
+    if (g_ForcedDayPart == DayPart::COUNT)
+    {
+        MinuteBlend const& b = g_DayBlend[GetMinuteOfDay()];
+        if (b.from != b.to)
+            oss << " (blending " << DayPartName(b.from) << "->" << DayPartName(b.to) << " " << (int)std::round(b.t * 100.0f) << "%)";
+    }
+    oss << "\n";
+
+    // rough footprint: hash nodes carry the key/value pair plus a next pointer and cached hash
+    size_t const zoneBytes = g_AutoZones.size() * (sizeof(std::pair<uint32 const, AutoZone>) + 2 * sizeof(void*))
+        + g_AutoZones.bucket_count() * sizeof(void*);
+    oss << "memory: last-applied " << g_LastApplied.Size() << " x " << sizeof(LastApplied) << " B = "
+        << g_LastApplied.RecordBytes() << " B (+" << g_LastApplied.IndexBytes() << " B index), auto zones "
+        << g_AutoZones.size() << " ~" << zoneBytes / 1024 << " KiB, wake queue "
+        << (g_ZoneWakes.Size() + g_NextTickWakes.size()) * sizeof(ZoneWake) << " B\n";
+
+    for (Region const& r : g_Regions)
+        oss << "Region " << r.name << " profile=" << r.profile << " zones=" << r.zones.size()
+            << " pick=" << WeatherStateName(r.state) << ":" << (int)std::round(r.pct)
+            << "% windowMs=" << (r.windowEndMs > g_EngineNowMs ? r.windowEndMs - g_EngineNowMs : 0) << "\n";
+
+    // zone lines: copy what they show here, format them on a task (thousands of zones on a big config)
+    std::vector<ZoneStatusRow> rows;
+    rows.reserve(g_AutoZones.size());
+    for (auto const& kv : g_AutoZones)
+    {
+        uint32 z = kv.first; AutoZone const& az = kv.second;
+        ZoneStatusRow row;
+        row.zone = z;
+        if (uint16 slot = AreaSlotOf(z))
+        {
+            row.areaZone = g_AreaControllers[slot].zone;
+            row.areaPlayers = (uint32)g_AreaPlayers[slot].size();
+        }
+        row.enabled = az.enabled;
+        row.profile = az.profile;
+        row.hasOverride = az.hasOverride;
+        row.curState = az.curState;
+        row.curPct = az.enabled ? TweenPctAt(az, g_EngineNowMs) : az.curPct;
+        row.tgtState = az.tgtState;
+        row.tgtPct = az.tgtPct;
+        row.windowMs = az.windowEndMs > g_EngineNowMs ? az.windowEndMs - g_EngineNowMs : 0;
+        row.tweenMs = TweenRemainMs(az);
+        row.wakeMs = az.wakeMs == UINT64_MAX ? UINT64_MAX : (az.wakeMs > g_EngineNowMs ? az.wakeMs - g_EngineNowMs : 0);
+        if (Sprinkle const* top = az.sprinkles.Top())
+        {
+            row.sprinkle = top->tag;
+            row.sprinklePriority = top->priority;
+            row.sprinkleCount = az.sprinkles.count;
+        }
+        if (az.region)
+            row.region = g_Regions[az.region - 1].name;
+        if (az.timeline.active)
+            row.timeline = g_Timelines[az.timeline.owner].name;
+        rows.push_back(std::move(row));
+    }
+
+    RunInBackground(handler, [header = oss.str(), rows = std::move(rows)]() -> CommandFinish
+    {
+        std::ostringstream out;
+        out << header;
+        for (ZoneStatusRow const& row : rows)
+        {
+            out << "Zone " << row.zone;
+            if (row.areaZone)
+                out << " (area in " << row.areaZone << ", " << row.areaPlayers << " players)";
+            out << " enabled=" << (row.enabled ? "1" : "0")
+                << " profile=" << row.profile << (row.hasOverride ? "+override" : "")
+                << " cur=" << WeatherStateName(row.curState) << ":" << (int)std::round(row.curPct)
+                << "% tgt=" << WeatherStateName(row.tgtState) << ":" << (int)std::round(row.tgtPct)
+                << "% windowMs=" << row.windowMs
+                << " tweenMs=" << row.tweenMs
+                << " wakeMs=" << (row.wakeMs == UINT64_MAX ? std::string("-") : std::to_string(row.wakeMs))
+                << (row.sprinkleCount ? " sprinkle=" + row.sprinkle + "/p" + std::to_string(row.sprinklePriority)
+                    + (row.sprinkleCount > 1 ? "(+" + std::to_string(row.sprinkleCount - 1) + ")" : "") : "")
+                << (!row.region.empty() ? " region=" + row.region : "")
+                << (!row.timeline.empty() ? " timeline=" + row.timeline : "")
+                << "\n";
+        }
+        return [text = out.str()](ChatHandler* to) { if (to) to->SendSysMessage(text.c_str()); };
+    });
+    return true;
+}
+
+// Walks one tween on the tick grid (fixed TinyNudge) and counts the packets it produces.
+static uint32 PlanTweenPackets(WeatherState state, float fromPct, float toPct, TweenCurve curve)
+{
+    Range const* ranges = ActiveRanges();
+    uint32 const tweenMs = g_TweenSec * 1000u;
+    float last = AutoGradeFor(ranges, state, fromPct);
+    uint32 packets = 1; // the state change itself
+    for (uint32 elapsed = g_AutoTickMs; ; elapsed += g_AutoTickMs)
+    {
+        float t = tweenMs ? std::min(1.0f, float(elapsed) / float(tweenMs)) : 1.0f;
+        float pct = fromPct + (toPct - fromPct) * EaseAt(curve, t);
+        float norm = AutoGradeFor(ranges, state, pct);
+        if (std::fabs(norm - last) >= g_TinyNudge)
+        {
+            ++packets;
+            last = norm;
+        }
+        if (t >= 1.0f)
+            return packets;
+    }
+}
+
+// .wvibe auto tweenplan <state> <fromPct> <toPct> -- packets per tween for each curve at current settings
+static bool HandleAutoTweenPlan(ChatHandler* handler, std::string stateToken, float fromPct, float toPct)
+{
+    WeatherState state;
+    if (!ParseStateToken(stateToken, state))
+    {
+        handler->SendSysMessage("|cff00ff00WeatherVibe:|r Usage: .wvibe auto tweenplan <state> <fromPct> <toPct>");
+        return false;
+    }
+    fromPct = std::clamp(fromPct, 0.0f, 100.0f);
+    toPct = std::clamp(toPct, 0.0f, 100.0f);
+
+    std::ostringstream oss;
+    oss << "Tween " << WeatherStateName(state) << " " << (int)fromPct << "%->" << (int)toPct << "% over " << g_TweenSec
+        << "s, tick=" << g_AutoTickMs << "ms, nudge=" << g_TinyNudge << ":";
+    for (uint8 c = 0; c < (uint8)TweenCurve::COUNT; ++c)
+        oss << " " << TweenCurveName((TweenCurve)c) << "=" << PlanTweenPackets(state, fromPct, toPct, (TweenCurve)c)
+            << ((TweenCurve)c == g_TweenCurve ? "*" : "");
+    oss << " packets";
+    handler->SendSysMessage(oss.str().c_str());
+    return true;
+}
+
+// .wvibe auto rates -- observed send rate per zone against the packet budget
+static bool HandleAutoRates(ChatHandler* handler)
+{
+    std::vector<uint32> zones;
+    float total = 0.0f, worst = 0.0f;
+    for (auto const& kv : g_AutoZones)
+    {
+        if (!kv.second.enabled) continue;
+        zones.push_back(kv.first);
+        float rate = SendRateNow(kv.second);
+        total += rate;
+        worst = std::max(worst, rate);
+    }
+    std::sort(zones.begin(), zones.end());
+
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(2)
+        << "Rates (packets/min, EWMA " << g_RateWindowSec << "s): mode=" << (g_PacketBudget > 0.0f ? "adaptive" : "fixed");
+    if (g_PacketBudget > 0.0f)
+        oss << " budget=" << g_PacketBudget << std::setprecision(4) << " nudge=[" << g_NudgeMin << "," << g_NudgeMax << "] minInterval=" << g_MinSendIntervalMs << "ms";
+    else
+        oss << std::setprecision(4) << " nudge=" << g_TinyNudge;
+    oss << std::setprecision(2);
+    oss << " zones=" << zones.size() << " total=" << total << " avg=" << (zones.empty() ? 0.0f : total / zones.size()) << " max=" << worst << "\n";
+
+    for (uint32 z : zones)
+    {
+        AutoZone const& az = g_AutoZones.at(z);
+        float rate = SendRateNow(az);
+        oss << "Zone " << z << " rate=" << rate;
+        if (g_PacketBudget > 0.0f)
+            oss << "/" << g_PacketBudget << (rate > g_PacketBudget ? " OVER" : "") << " nudge=" << std::setprecision(4) << az.nudge << std::setprecision(2);
+        oss << " lastSend=" << (g_EngineNowMs - az.lastSendMs) / 1000 << "s ago\n";
+    }
+
+    handler->SendSysMessage(oss.str().c_str());
+    return true;
+}
+
+static bool HandleAutoSet(ChatHandler* handler, std::string zones, std::string profileName)
+{
+    if (RejectWhileReloading(handler))
+        return false;
+    std::string key = Lower(profileName);
+    if (!g_Profiles.count(key))
+    {
+        handler->PSendSysMessage("|cff00ff00WeatherVibe:|r Unknown profile '%s'", profileName.c_str());
+        return false;
+    }
+
+    std::vector<uint32> controllers;
+    if (!ResolveZoneSelector(handler, zones, controllers))
+        return false;
+
+    for (uint32 controller : controllers)
+    {
+        EnsureAutoZone(controller);
+        AutoZone& az = g_AutoZones[controller];
+        az.enabled = true;
+        az.profile = key;
+        ResolveEffectiveProfile(controller, az);
+        az.windowEndMs = 0; // force a fresh pick
+        ScheduleZoneWake(controller, az, g_EngineNowMs);
+    }
+    handler->PSendSysMessage("|cff00ff00WeatherVibe:|r %u zone(s) now auto-controlled by profile '%s': %s", (uint32)controllers.size(),
+        profileName.c_str(), FormatZoneList(controllers).c_str());
+    return true;
 }
 
-static void ChooseNewTarget([[maybe_unused]] uint32 controllerZone, AutoZone& az)
+static bool HandleAutoClear(ChatHandler* handler, std::string zones)
 {
-    auto itp = g_Profiles.find(az.profile);
-    if (itp == g_Profiles.end())
-    {
-        // fallback: any default profile
-        if (!g_Profiles.empty()) itp = g_Profiles.begin();
-    }
+    if (RejectWhileReloading(handler))
+        return false;
+    std::vector<uint32> controllers;
+    if (!ResolveZoneSelector(handler, zones, controllers))
+        return false;
 
-    if (itp == g_Profiles.end())
+    uint32 cleared = 0;
+    for (uint32 controller : controllers)
     {
-        // no profiles at all -> fine 0
-        az.tgtState = WEATHER_STATE_FINE;
-        az.tgtPct = 0.0f;
-        az.windowRemainMs = RandWindowMs();
-        az.tweenRemainMs = g_TweenSec * 1000u;
-        return;
+        auto it = g_AutoZones.find(controller);
+        if (it == g_AutoZones.end() || !it->second.enabled) continue;
+        it->second.enabled = false;
+        PruneAutoZone(controller);
+        ++cleared;
     }
-
-    Profile const& p = itp->second;
-    az.tgtState = PickStateFromWeights(p);
-    az.tgtPct = RandPercentBetween(p);
-    az.windowRemainMs = RandWindowMs();
-    az.tweenRemainMs = g_TweenSec * 1000u;
+    handler->PSendSysMessage("|cff00ff00WeatherVibe:|r auto control disabled on %u of %u zone(s): %s", cleared, (uint32)controllers.size(),
+        FormatZoneList(controllers).c_str());
+    return cleared != 0;
 }
 
-static void ApplyAutoTick(uint32 diffMs)
+// .wvibe auto sprinkle <zones> <state|auto> <pct> <sec> [priority:0..255] [tag]
+static bool HandleAutoSprinkle(ChatHandler* handler, std::string zones, std::string stateToken, float percentage, uint32 durationSec,
+    Optional<uint32> priority, Optional<std::string> tag)
 {
-    if (!g_AutoEnabled) return;
+    if (RejectWhileReloading(handler))
+        return false;
+    if (percentage < 0.0f) percentage = 0.0f; if (percentage > 100.0f) percentage = 100.0f;
 
-    DayPart dp = GetCurrentDayPart();
+    std::vector<uint32> controllers;
+    if (!ResolveZoneSelector(handler, zones, controllers))
+        return false;
 
-    for (auto& kv : g_AutoZones)
+    uint8 prio = (uint8)std::min<uint32>(priority.value_or(0), 255);
+    std::string tagKey = Lower(tag.value_or("gm"));
+    uint32 applied = 0, shadowed = 0, notAuto = 0, full = 0;
+    for (uint32 controller : controllers)
     {
-        uint32 controllerZone = kv.first;
-        AutoZone& az = kv.second;
-        if (!az.enabled) continue;
-
-        // handle sprinkle override timer first
-        if (az.sprinkle.active)
+        auto it = g_AutoZones.find(controller);
+        if (it == g_AutoZones.end())
         {
-            if (diffMs >= az.sprinkle.remainMs) az.sprinkle.remainMs = 0; else az.sprinkle.remainMs -= diffMs;
-            if (az.sprinkle.remainMs == 0) az.sprinkle.active = false; // expire
+            ++notAuto;
+            continue;
         }
 
-        // advance window timer & choose new target if needed
-        if (az.windowRemainMs == 0)
-            ChooseNewTarget(controllerZone, az);
-        else
-            az.windowRemainMs = (diffMs >= az.windowRemainMs) ? 0 : (az.windowRemainMs - diffMs);
-
-        // tween toward target (or hold if sprinkle active—still tween grade for smoothness)
-        if (az.tweenRemainMs == 0)
+        AutoZone& az = it->second;
+        Sprinkle sp;
+        sp.id = g_NextSprinkleId++;
+        sp.priority = prio;
+        sp.state = az.curState;
+        if (stateToken != "auto")
+            ParseStateToken(stateToken, sp.state); // numeric or name; unknown keeps the current state
+        sp.pct = percentage;
+        sp.tag = tagKey;
+        if (!az.sprinkles.Push(sp))
         {
-            // already at target; keep current
-            az.curState = az.tgtState;
-            az.curPct = az.tgtPct;
+            ++full;
+            continue;
         }
-        else
-        {
-            // adopt the new weather STATE immediately; still tween intensity (percent)
-            az.curState = az.tgtState;
+        g_SprinkleExpiry.Push(g_EngineNowMs + uint64(durationSec) * 1000u, { controller, sp.id });
+        ScheduleZoneWake(controller, az, g_EngineNowMs);
+        ++applied;
+        if (az.sprinkles.Top()->id != sp.id) ++shadowed;
+    }
 
-            float t = 1.0f - (float)az.tweenRemainMs / (float)(g_TweenSec * 1000u);
-            float src = az.curPct;
-            float dst = az.tgtPct;
-            float cur = src + (dst - src) * std::clamp(t, 0.0f, 1.0f);
-            az.curPct = cur;
-            az.tweenRemainMs = (diffMs >= az.tweenRemainMs) ? 0 : (az.tweenRemainMs - diffMs);
-        }
+    handler->PSendSysMessage("|cff00ff00WeatherVibe:|r Sprinkle '%s' (priority %u) %s %.0f%% for %u sec applied to %u zone(s) (%u under a higher priority, %u not auto-controlled, %u full): %s",
+        tagKey.c_str(), prio, stateToken.c_str(), percentage, durationSec, applied, shadowed, notAuto, full, FormatZoneList(controllers).c_str());
+    return applied != 0;
+}
 
-        // Decide what to push this tick (sprinkle overrides state/pct if active)
-        WeatherState outState = az.sprinkle.active ? az.sprinkle.state : az.curState;
-        float outPct = az.sprinkle.active ? az.sprinkle.pct : az.curPct;
+// .wvibe auto unsprinkle <zones> [tag] -- no tag removes all
+static bool HandleAutoUnsprinkle(ChatHandler* handler, std::string zones, Optional<std::string> tag)
+{
+    if (RejectWhileReloading(handler))
+        return false;
+    std::vector<uint32> controllers;
+    if (!ResolveZoneSelector(handler, zones, controllers))
+        return false;
 
-        // Map percent to raw grade for CURRENT daypart (dynamic bands)
-        float raw = MapPercentToRawGrade(dp, outState, outPct / 100.0f);
-        float norm = ClampToCoreBounds(raw, outState);
+    uint32 removed = 0;
+    std::string tagKey = Lower(tag.value_or(""));
+    for (uint32 controller : controllers)
+    {
+        auto it = g_AutoZones.find(controller);
+        if (it == g_AutoZones.end()) continue;
+        uint32 n = it->second.sprinkles.RemoveTag(tagKey);
+        if (n) ScheduleZoneWake(controller, it->second, g_EngineNowMs);
+        removed += n;
+    }
+    handler->PSendSysMessage("|cff00ff00WeatherVibe:|r Removed %u sprinkle(s) from %u zone(s): %s", removed, (uint32)controllers.size(), FormatZoneList(controllers).c_str());
+    return removed != 0;
+}
 
-        // tiny nudge filter
-        float delta = (az.lastRawSent < 0.0f) ? 1.0f : std::fabs(norm - az.lastRawSent);
-        bool stateChanged = (outState != az.lastStateSent);
-        if (stateChanged || delta >= g_TinyNudge)
+// --- Timeline subcommands ---
+static bool HandleTimelineList(ChatHandler* handler)
+{
+    std::ostringstream oss;
+    oss << "Timelines=" << g_Timelines.size() << " queued=" << g_TimelineQueue.Size() << "\n";
+    for (Timeline const& tl : g_Timelines)
+    {
+        oss << tl.name << " zones=" << tl.zones.size() << " steps=" << tl.steps.size() << " start=";
+        if (tl.startMinute >= 0)
+            oss << std::setfill('0') << std::setw(2) << tl.startMinute / 60 << ":" << std::setw(2) << tl.startMinute % 60 << std::setfill(' ');
+        else
+            oss << "manual";
+        if (tl.run)
         {
-            bool delivered = PushWeatherToClient(controllerZone, outState, norm);
-            (void)delivered; // used only in debug text
-            az.lastRawSent = norm;
-            az.lastStateSent = outState;
+            TimelineStep const& st = tl.steps[tl.step];
+            oss << " running step " << (tl.step + 1) << "/" << tl.steps.size() << " (" << WeatherStateName(st.state) << ":" << (int)std::round(st.pct) << "%)";
         }
+        oss << "\n";
     }
+    handler->SendSysMessage(oss.str().c_str());
+    return true;
 }
 
-// ======================================
-// Commands
-// ======================================
-// .wvibe set <zoneId> <state:uint> <percentage:0..100>
-static bool HandleCommandPercent(ChatHandler* handler, uint32 zoneId, uint32 stateVal, float percentage)
+static bool HandleTimelineStart(ChatHandler* handler, std::string name)
 {
-    if (!g_EnableModule)
+    if (RejectWhileReloading(handler))
+        return false;
+    uint32 index = 0;
+    if (!FindTimeline(name, &index))
     {
-        handler->SendSysMessage("|cff00ff00WeatherVibe:|r module is disabled in config.");
+        handler->PSendSysMessage("|cff00ff00WeatherVibe:|r Unknown timeline '%s'", name.c_str());
         return false;
     }
-    if (!IsValidWeatherState(stateVal))
+    StartTimeline(index);
+    ProcessDueTimelines(); // first step applies now, not on the next tick
+    handler->PSendSysMessage("|cff00ff00WeatherVibe:|r Timeline '%s' started (%u zones, %u steps)", g_Timelines[index].name.c_str(),
+        (uint32)g_Timelines[index].zones.size(), (uint32)g_Timelines[index].steps.size());
+    return true;
+}
+
+static bool HandleTimelineStop(ChatHandler* handler, std::string name)
+{
+    if (RejectWhileReloading(handler))
+        return false;
+    uint32 index = 0;
+    if (!FindTimeline(name, &index))
     {
-        handler->SendSysMessage("|cff00ff00WeatherVibe:|r Invalid state. Examples: 0=Fine, 1=Fog, 3=LightRain, 4=MediumRain, 5=HeavyRain, 6=LightSnow, 7=MediumSnow, 8=HeavySnow, 22=LightSandstorm, 41=MediumSandstorm, 42=HeavySandstorm, 86=Thunders.");
-        handler->SendSysMessage("Usage: .wvibe set <zoneId> <state:uint> <percentage:0..100>");
+        handler->PSendSysMessage("|cff00ff00WeatherVibe:|r Unknown timeline '%s'", name.c_str());
         return false;
     }
-
-    float pct01 = std::clamp(percentage, 0.0f, 100.0f) / 100.0f;
-    DayPart dp = GetCurrentDayPart();
-    float raw = MapPercentToRawGrade(dp, static_cast<WeatherState>(stateVal), pct01);
-
-    bool ok = PushWeatherToClient(zoneId, (WeatherState)stateVal, raw);
-    SyncAutoWithManual(zoneId, (WeatherState)stateVal, raw);
-    return ok;
+    StopTimeline(index);
+    handler->PSendSysMessage("|cff00ff00WeatherVibe:|r Timeline '%s' stopped; zones return to auto", g_Timelines[index].name.c_str());
+    return true;
 }
 
-// .wvibe setRaw <zoneId> <state:uint> <raw:0..1>
-static bool HandleCommandRaw(ChatHandler* handler, uint32 zoneId, uint32 stateVal, float grade)
+// .wvibe timeline run <name> <zone,zone,...> <state:pct:sec,...> -- defines (or replaces) and starts
+static bool HandleTimelineRun(ChatHandler* handler, std::string name, std::string zones, std::string steps)
 {
-    if (!g_EnableModule)
+    if (RejectWhileReloading(handler))
+        return false;
+    uint32 errorsBefore = g_ParseErrors;
+    Timeline tl;
+    tl.name = name;
+    ParseTimelineZones("timeline zones", zones, tl.zones);
+    ParseTimelineSteps("timeline steps", steps, tl.steps);
+    if (g_ParseErrors != errorsBefore || tl.zones.empty() || tl.steps.empty())
     {
-        handler->SendSysMessage("|cff00ff00WeatherVibe:|r module is disabled in config.");
+        g_ParseErrors = errorsBefore; // command typos are not config errors
+        handler->SendSysMessage("|cff00ff00WeatherVibe:|r Usage: .wvibe timeline run <name> <zone,zone,...> <state:pct:sec,...> (e.g. fog:40:600,thunders:80:300,fine:0:60)");
         return false;
     }
-    if (!IsValidWeatherState(stateVal))
+
+    uint32 index = 0;
+    if (Timeline* existing = FindTimeline(name, &index))
     {
-        handler->SendSysMessage("|cff00ff00WeatherVibe:|r Invalid state. Usage: .wvibe setRaw <zoneId> <state:uint> <raw:0..1>");
-        return false;
+        StopTimeline(index);
+        tl.startMinute = existing->startMinute;
+        *existing = std::move(tl);
     }
+    else
+        g_Timelines.push_back(std::move(tl));
 
-    float raw = std::clamp(grade, 0.0f, 1.0f);
-    bool ok = PushWeatherToClient(zoneId, (WeatherState)stateVal, raw);
-    SyncAutoWithManual(zoneId, (WeatherState)stateVal, raw);
-    return ok;
+    return HandleTimelineStart(handler, name);
 }
 
-// --- Auto subcommands ---
-static bool HandleAutoOn(ChatHandler* handler)
+// --- Player subcommands (.wvibe me) ---
+static Player* PersonalCommandPlayer(ChatHandler* handler)
 {
-    g_AutoEnabled = true;
-    handler->SendSysMessage("|cff00ff00WeatherVibe:|r auto engine: ON");
-    return true;
+    if (!g_EnableModule || !g_PersonalEnabled)
+    {
+        handler->SendSysMessage("|cff00ff00WeatherVibe:|r personal weather settings are disabled.");
+        return nullptr;
+    }
+    return handler->GetPlayer();
 }
 
-static bool HandleAutoOff(ChatHandler* handler)
+static std::string DescribePlayerPrefs(PlayerPrefs const& prefs)
 {
-    g_AutoEnabled = false;
-    handler->SendSysMessage("|cff00ff00WeatherVibe:|r auto engine: OFF");
-    return true;
+    std::ostringstream oss;
+    oss << "cap=" << (uint32)prefs.maxPct << "% blocked=";
+    bool any = false;
+    for (size_t i = 0; i < kStateCount; ++i)
+        if ((prefs.blocked >> i) & 1u)
+        {
+            oss << (any ? "," : "") << WeatherStateName(kAcceptedStates[i]);
+            any = true;
+        }
+    if (!any)
+        oss << "none";
+    return oss.str();
 }
 
-static bool HandleAutoStatus(ChatHandler* handler)
+// Stores (or drops, when back to defaults) the player's settings and shows the result right away.
+static bool CommitPlayerPrefs(ChatHandler* handler, Player* player, PlayerPrefs const& prefs)
 {
-    std::ostringstream oss;
-    oss << "Auto=" << (g_AutoEnabled ? "on" : "off")
-        << " tickMs=" << g_AutoTickMs
-        << " window=[" << g_MinWindowSec << "," << g_MaxWindowSec << "]s"
-        << " tween=" << g_TweenSec << "s\n";
-
-    for (auto const& kv : g_AutoZones)
-    {
-        uint32 z = kv.first; AutoZone const& az = kv.second;
-        oss << "Zone " << z << " enabled=" << (az.enabled ? "1" : "0")
-            << " profile=" << az.profile
-            << " cur=" << WeatherStateName(az.curState) << ":" << (int)std::round(az.curPct)
-            << "% tgt=" << WeatherStateName(az.tgtState) << ":" << (int)std::round(az.tgtPct)
-            << "% windowMs=" << az.windowRemainMs
-            << " tweenMs=" << az.tweenRemainMs
-            << (az.sprinkle.active ? " sprinkle=1" : "")
-            << "\n";
-    }
-
-    handler->SendSysMessage(oss.str().c_str());
+    uint32 guidLow = player->GetGUID().GetCounter();
+    if (prefs.IsDefault())
+        g_PlayerPrefs.erase(guidLow);
+    else
+        g_PlayerPrefs[guidLow] = prefs;
+    SavePlayerPrefs(guidLow, prefs);
+
+    TrackPersonalizedPlayer(guidLow, player->GetZoneId());
+    PushLastAppliedWeatherToClient(WeatherRecipient{ player->GetGUID(), player }, player->GetZoneId());
+    handler->PSendSysMessage("|cff00ff00WeatherVibe:|r your weather: %s", DescribePlayerPrefs(prefs).c_str());
     return true;
 }
 
-static bool HandleAutoSet(ChatHandler* handler, uint32 zoneId, std::string profileName)
+static PlayerPrefs CurrentPlayerPrefs(Player const* player)
 {
-    uint32 controller = ResolveControllerZone(zoneId);
-    std::string key = Lower(profileName);
+    auto it = g_PlayerPrefs.find(player->GetGUID().GetCounter());
+    return it == g_PlayerPrefs.end() ? PlayerPrefs{} : it->second;
+}
 
-    if (!g_Profiles.count(key))
-    {
-        handler->PSendSysMessage("|cff00ff00WeatherVibe:|r Unknown profile '%s'", profileName.c_str());
+static bool HandleMeShow(ChatHandler* handler)
+{
+    Player* player = PersonalCommandPlayer(handler);
+    if (!player)
         return false;
-    }
-
-    EnsureAutoZone(controller);
-    AutoZone& az = g_AutoZones[controller];
-    az.enabled = true;
-    az.profile = key;
-    az.windowRemainMs = 0; // force a fresh pick
-    handler->PSendSysMessage("|cff00ff00WeatherVibe:|r Zone %u is now auto-controlled by profile '%s' (controller=%u)", zoneId, profileName.c_str(), controller);
+    handler->PSendSysMessage("|cff00ff00WeatherVibe:|r your weather: %s (.wvibe me cap <0-100> | block <state> | unblock <state|all> | reset)",
+        DescribePlayerPrefs(CurrentPlayerPrefs(player)).c_str());
     return true;
 }
 
-static bool HandleAutoClear(ChatHandler* handler, uint32 zoneId)
+static bool HandleMeCap(ChatHandler* handler, uint32 percent)
 {
-    uint32 controller = ResolveControllerZone(zoneId);
-    auto it = g_AutoZones.find(controller);
-    if (it != g_AutoZones.end())
-    {
-        it->second.enabled = false;
-        handler->PSendSysMessage("|cff00ff00WeatherVibe:|r Zone %u auto control disabled (controller=%u)", zoneId, controller);
-        return true;
-    }
-    handler->PSendSysMessage("|cff00ff00WeatherVibe:|r Zone %u has no auto control", zoneId);
-    return false;
+    Player* player = PersonalCommandPlayer(handler);
+    if (!player)
+        return false;
+    PlayerPrefs prefs = CurrentPlayerPrefs(player);
+    prefs.maxPct = (uint8)std::min<uint32>(percent, 100);
+    return CommitPlayerPrefs(handler, player, prefs);
 }
 
-static bool HandleAutoSprinkle(ChatHandler* handler, uint32 zoneId, std::string stateToken, float percentage, uint32 durationSec)
+static bool HandleMeBlock(ChatHandler* handler, std::string stateToken)
 {
-    if (percentage < 0.0f) percentage = 0.0f; if (percentage > 100.0f) percentage = 100.0f;
-
-    uint32 controller = ResolveControllerZone(zoneId);
-    auto it = g_AutoZones.find(controller);
-    if (it == g_AutoZones.end())
+    Player* player = PersonalCommandPlayer(handler);
+    if (!player)
+        return false;
+    WeatherState state;
+    size_t idx = ParseStateToken(stateToken, state) ? StateIndex(state) : kStateCount;
+    if (idx == kStateCount || state == WEATHER_STATE_FINE)
     {
-        handler->PSendSysMessage("|cff00ff00WeatherVibe:|r Zone %u is not under auto control; use .wvibe auto set <zone> <profile> first.", zoneId);
+        handler->SendSysMessage("|cff00ff00WeatherVibe:|r Usage: .wvibe me block <state> (e.g. fog, thunders, 86)");
         return false;
     }
+    PlayerPrefs prefs = CurrentPlayerPrefs(player);
+    prefs.blocked |= uint16(1u << idx);
+    return CommitPlayerPrefs(handler, player, prefs);
+}
 
-    AutoZone& az = it->second;
-
-    WeatherState s = az.curState;
-    if (stateToken != "auto")
+static bool HandleMeUnblock(ChatHandler* handler, std::string stateToken)
+{
+    Player* player = PersonalCommandPlayer(handler);
+    if (!player)
+        return false;
+    PlayerPrefs prefs = CurrentPlayerPrefs(player);
+    WeatherState state;
+    if (Lower(stateToken) == "all")
+        prefs.blocked = 0;
+    else if (ParseStateToken(stateToken, state) && StateIndex(state) != kStateCount)
+        prefs.blocked &= uint16(~(1u << StateIndex(state)));
+    else
     {
-        // parse numeric or known token
-        uint32 val = 0;
-        if (std::sscanf(stateToken.c_str(), "%u", &val) == 1 && IsValidWeatherState(val))
-            s = static_cast<WeatherState>(val);
-        else
-        {
-            // try names: fine,fog,light_rain,...
-            std::string l = Lower(stateToken);
-            for (WeatherState ws : kAcceptedStates)
-                if (l == WeatherStateName(ws)) { s = ws; break; }
-        }
+        handler->SendSysMessage("|cff00ff00WeatherVibe:|r Usage: .wvibe me unblock <state|all>");
+        return false;
     }
+    return CommitPlayerPrefs(handler, player, prefs);
+}
 
-    az.sprinkle.active = true;
-    az.sprinkle.state = s;
-    az.sprinkle.pct = percentage;
-    az.sprinkle.remainMs = durationSec * 1000u;
-
-    handler->PSendSysMessage("|cff00ff00WeatherVibe:|r Sprinkle applied to zone %u (controller=%u): %s %.0f%% for %u sec", zoneId, controller, WeatherStateName(s), percentage, durationSec);
-    return true;
+static bool HandleMeReset(ChatHandler* handler)
+{
+    Player* player = PersonalCommandPlayer(handler);
+    if (!player)
+        return false;
+    return CommitPlayerPrefs(handler, player, PlayerPrefs{});
 }
 
 class WeatherVibe_CommandScript : public CommandScript
@@ -1005,13 +5732,37 @@ public:
             return false;
         }
 
-        LoadDayPartConfig();
-        LoadStateRanges();
-        LoadProfiles();
-        LoadAutoConfig();
-        InitializeAutoZonesFromConfig();
+        if (g_ReloadPending)
+        {
+            handler->SendSysMessage("|cff00ff00WeatherVibe:|r a reload is already running; try again once it reports back.");
+            return false;
+        }
+
+        // sims, loadtests and selftests step copies of zones built against the current tables
+        if (!g_SlicedCommands.empty())
+        {
+            handler->SendSysMessage("|cff00ff00WeatherVibe:|r a sim, loadtest or selftest is still running; try again once it reports back.");
+            return false;
+        }
 
-        handler->SendSysMessage("|cff00ff00WeatherVibe:|r reloaded (ranges/dayparts/parents/profiles/auto).");
+        // parse + zone build run on a task against copies of the seeding inputs; the world keeps
+        // ticking the old tables until the result is installed
+        g_ReloadPending = true;
+        RunInBackground(handler, [config = ConfigSnapshot::Take(), lastApplied = g_LastApplied, nowMs = g_EngineNowMs]() -> CommandFinish
+        {
+            auto r = std::make_shared<ReloadResult>();
+            r->config = config;
+            BuildReload(*r, lastApplied, nowMs);
+            return [r](ChatHandler* to)
+            {
+                InstallReload(*r);
+                g_ReloadPending = false;
+                LogConfigSummary(r->parseUs);
+                if (to)
+                    to->PSendSysMessage("|cff00ff00WeatherVibe:|r reloaded (ranges/dayparts/parents/profiles/auto/regions/timelines) in %u us (+%u us zones), %u parse errors (see server log).",
+                        (uint32)r->parseUs, (uint32)r->buildUs, g_ParseErrors);
+            };
+        });
         return true;
     }
 
@@ -1023,7 +5774,7 @@ public:
             return false;
         }
 
-        if (g_LastApplied.empty())
+        if (g_LastApplied.Empty())
         {
             handler->SendSysMessage("|cff00ff00WeatherVibe:|r No last-applied weather recorded yet. Use .wvibe set or setRaw to push weather.");
             return true;
@@ -1033,32 +5784,298 @@ public:
         DayPart d = GetCurrentDayPart();
 
         std::ostringstream oss;
-        oss << "|cff00ff00WeatherVibe:|r show | season=" << SeasonName(s) << " daypart=" << DayPartName(d) << "\n";
-
-        for (auto const& kv : g_LastApplied)
-        {
-            uint32 zoneId = kv.first;
-            LastApplied const& la = kv.second;
-            float pct = RawToPercent01(d, la.state, la.grade) * 100.0f;
-            oss << "zone " << zoneId
-                << " -> last state=" << WeatherStateName(la.state)
-                << " raw=" << std::fixed << std::setprecision(2) << la.grade
-                << " (" << std::setprecision(0) << pct << "%)"
-                << (la.hasValue ? "" : " (unset)")
-                << "\n";
+        oss << "|cff00ff00WeatherVibe:|r show | season=" << SeasonName(s) << " daypart=" << DayPartName(d)
+            << " | personal=" << (g_PersonalEnabled ? "on" : "off") << " (" << g_PlayerPrefs.size() << " stored, "
+            << g_PersonalizedOnline.size() << " online in " << g_PersonalizedPerZone.size() << " zones)\n";
+
+        // one line per recorded zone: format a copy of the records on a task
+        std::array<Range, kStateCount> ranges;
+        std::copy_n(ActiveRanges(), kStateCount, ranges.begin());
+        RunInBackground(handler, [header = oss.str(), records = g_LastApplied.Records(), ranges]() -> CommandFinish
+        {
+            std::ostringstream out;
+            out << header;
+            for (LastApplied const& la : records)
+            {
+                float pct = RawToPercent01(ranges.data(), la.State(), la.Grade()) * 100.0f;
+                out << "zone " << la.zone
+                    << " -> last state=" << WeatherStateName(la.State())
+                    << " raw=" << std::fixed << std::setprecision(2) << la.Grade()
+                    << " (" << std::setprecision(0) << pct << "%)"
+                    << "\n";
+            }
+            return [text = out.str()](ChatHandler* to) { if (to) to->SendSysMessage(text.c_str()); };
+        });
+        return true;
+    }
+
+    // .wvibe bench parse [iterations] -- parses a config snapshot into scratch tables on a background
+    // task (live tables untouched)
+    static bool HandleWvibeBenchParse(ChatHandler* handler, Optional<uint32> iterations)
+    {
+        uint32 n = std::clamp<uint32>(iterations.value_or(100), 1, 10000);
+        RunInBackground(handler, [n, config = ConfigSnapshot::Take()]() -> CommandFinish
+        {
+            uint64 total = 0, best = UINT64_MAX, worst = 0;
+            uint32 errors = 0;
+            ConfigTables scratch;
+            {
+                ParseCounterScope keepLiveCounters; // the console runs this in place
+                for (uint32 i = 0; i < n; ++i)
+                {
+                    g_ParseQuiet = i > 0;
+                    scratch = ConfigTables{};
+                    uint64 us = ParseConfigTables(scratch, *config);
+                    total += us;
+                    best = std::min(best, us);
+                    worst = std::max(worst, us);
+                }
+                errors = g_ParseErrors;
+            }
+
+            return [=, profiles = (uint32)scratch.profiles.size(), zoneMaps = (uint32)scratch.zoneProfile.size(),
+                parents = (uint32)scratch.zoneParent.size()](ChatHandler* to)
+            {
+                if (to)
+                    to->PSendSysMessage("|cff00ff00WeatherVibe:|r parse bench x%u: avg=%u us min=%u us max=%u us (%u profiles, %u zone maps, %u parents, %u errors)",
+                        n, (uint32)(total / n), (uint32)best, (uint32)worst, profiles, zoneMaps, parents, errors);
+            };
+        });
+        return true;
+    }
+
+    // .wvibe bench areas [players] [moves] -- synthetic players walking between controlled areas and
+    // their zones: cost per move and per zone-broadcast recipient, area path vs the zone-only path
+    static bool HandleWvibeBenchAreas(ChatHandler* handler, Optional<uint32> players, Optional<uint32> moves)
+    {
+        if (g_AreaControllers.size() <= 1)
+        {
+            handler->SendSysMessage("|cff00ff00WeatherVibe:|r no area controllers configured (WeatherVibe.AreaProfile.Map).");
+            return false;
+        }
+
+        uint32 const np = std::clamp<uint32>(players.value_or(1000), 1, kMaxBenchPlayers);
+        uint32 const nm = std::clamp<uint32>(moves.value_or(100000), 1, kMaxBenchMoves);
+
+        // every controlled area, plus its zone outside any controlled area
+        std::vector<std::pair<uint32, uint32>> spots;
+        for (size_t slot = 1; slot < g_AreaControllers.size(); ++slot)
+        {
+            spots.emplace_back(g_AreaControllers[slot].zone, g_AreaControllers[slot].area);
+            spots.emplace_back(g_AreaControllers[slot].zone, g_AreaControllers[slot].zone);
+        }
+
+        // scratch occupancy: live players stay filed where they are
+        PlayerTrackingState scratch(g_AreaControllers.size());
+        SwapScope<PlayerTrackingState> useScratch(scratch);
+
+        std::mt19937 rng(1);
+        std::vector<ObjectGuid> guids;
+        std::vector<std::pair<uint32, uint32>> plan(nm);
+        std::vector<uint32> who(nm);
+        for (uint32 i = 0; i < np; ++i)
+            guids.push_back(ObjectGuid::Create<HighGuid::Player>(kLoadGuidBase + i));
+        for (uint32 m = 0; m < nm; ++m)
+        {
+            who[m] = rng() % np;
+            plan[m] = spots[rng() % spots.size()];
+        }
+
+        using Clock = std::chrono::steady_clock;
+        auto ns = [](Clock::duration d, uint32 n) { return (uint32)(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count() / std::max<uint32>(n, 1)); };
+
+        // zone-only path: a move resolves the zone's controller and sends on a controller change
+        std::vector<uint32> controllerOf(np, 0);
+        uint32 zoneChanges = 0;
+        auto t0 = Clock::now();
+        for (uint32 m = 0; m < nm; ++m)
+        {
+            uint32 controller = ResolveControllerZone(plan[m].first);
+            zoneChanges += controller != controllerOf[who[m]] ? 1 : 0;
+            controllerOf[who[m]] = controller;
+        }
+        auto zoneMove = Clock::now() - t0;
+
+        // area path: also files the player under its area and resolves the area-or-zone source
+        std::vector<uint32> sourceOf(np, 0);
+        uint32 changes = 0;
+        t0 = Clock::now();
+        for (uint32 m = 0; m < nm; ++m)
+        {
+            ObjectGuid const guid = guids[who[m]];
+            MovePlayerArea(guid, plan[m].first, plan[m].second);
+            uint16 slot = PlayerAreaSlot(guid.GetCounter());
+            uint32 source = slot ? g_AreaControllers[slot].area : ResolveControllerZone(plan[m].first);
+            changes += source != sourceOf[who[m]] ? 1 : 0;
+            sourceOf[who[m]] = source;
+        }
+        auto areaMove = Clock::now() - t0;
+
+        // extra per-recipient check a zone broadcast does while its controlled areas are occupied
+        uint32 const reps = std::max<uint32>(kMaxBenchMoves / np, 1);
+        uint32 inside = 0;
+        t0 = Clock::now();
+        for (uint32 rep = 0; rep < reps; ++rep)
+            for (ObjectGuid const& guid : guids)
+                inside += PlayerAreaSlot(guid.GetCounter()) ? 1 : 0;
+        auto recipient = Clock::now() - t0;
+        inside /= reps;
+
+        handler->PSendSysMessage("|cff00ff00WeatherVibe:|r area bench: %u areas, index %u bytes; %u players x %u moves: area path %u ns/move (%u packets) vs zone-only %u ns/move (%u packets); "
+            "zone broadcast skip check %u ns/recipient (%u of %u players inside areas)",
+            (uint32)g_AreaControllers.size() - 1, (uint32)(g_AreaSlot.size() * sizeof(uint16)), np, nm,
+            ns(areaMove, nm), changes, ns(zoneMove, nm), zoneChanges, ns(recipient, np * reps), inside, np);
+        return true;
+    }
+
+    // .wvibe sim <days> [seed] [path] -- fast-forwards the auto engine offline and writes a per-zone trace
+    static bool HandleWvibeSim(ChatHandler* handler, uint32 days, Optional<uint32> seed, Optional<std::string> path)
+    {
+        if (!days || days > kMaxSimDays)
+        {
+            handler->PSendSysMessage("|cff00ff00WeatherVibe:|r Usage: .wvibe sim <days:1..%u> [seed] [path]", kMaxSimDays);
+            return false;
+        }
+
+        std::string file, error;
+        if (!ResolveOutputPath(path.value_or("weathervibe_sim.tsv"), file, error))
+        {
+            handler->PSendSysMessage("|cff00ff00WeatherVibe:|r sim: %s", error.c_str());
+            return false;
+        }
+
+        if (RejectWhileReloading(handler) || RejectWhileSlicesFull(handler))
+            return false;
+
+        auto run = std::make_shared<SimRun>(days, seed.value_or(1));
+        RunInSlices(handler, [run, file](SliceClock::time_point deadline) -> CommandFinish
+        {
+            if (!run->Step(deadline))
+                return {};
+
+            bool const written = WriteSimTrace(run->Trace(), file);
+            return [run, file, written](ChatHandler* to)
+            {
+                if (!to)
+                    return;
+                if (!written)
+                {
+                    to->PSendSysMessage("|cff00ff00WeatherVibe:|r sim: cannot write %s", file.c_str());
+                    return;
+                }
+
+                SimTrace const& trace = run->Trace();
+                uint64 pushes = 0, changes = 0;
+                for (size_t i = 0; i < trace.zones.size(); ++i) { pushes += trace.pushes[i]; changes += trace.changes[i]; }
+                double zoneHours = double(trace.zones.size()) * trace.days * 24.0;
+                to->PSendSysMessage("|cff00ff00WeatherVibe:|r simulated %u day(s) x %u zones in %u ms: %u pushes (%.1f per zone-hour), %u state changes -> %s",
+                    trace.days, (uint32)trace.zones.size(), (uint32)(trace.wallUs / 1000), (uint32)pushes, zoneHours > 0.0 ? pushes / zoneHours : 0.0,
+                    (uint32)changes, file.c_str());
+            };
+        });
+        return true;
+    }
+
+    // .wvibe loadtest <players> [ticks] [seed] -- synthetic login storm + ticks through a recording sink
+    static bool HandleWvibeLoadTest(ChatHandler* handler, uint32 players, Optional<uint32> ticks, Optional<uint32> seed)
+    {
+        if (!players || players > kMaxLoadPlayers)
+        {
+            handler->PSendSysMessage("|cff00ff00WeatherVibe:|r Usage: .wvibe loadtest <players:1..%u> [ticks:0..%u] [seed]", kMaxLoadPlayers, kMaxLoadTicks);
+            return false;
         }
 
-        handler->SendSysMessage(oss.str().c_str());
+        if (RejectWhileReloading(handler) || RejectWhileSlicesFull(handler))
+            return false;
+
+        auto run = std::make_shared<LoadRun>(players, std::min(ticks.value_or(600), kMaxLoadTicks), seed.value_or(1));
+        if (!run->Report().spots)
+        {
+            handler->SendSysMessage("|cff00ff00WeatherVibe:|r loadtest: no enabled auto zones or areas to place players in.");
+            return false;
+        }
+
+        RunInSlices(handler, [run](SliceClock::time_point deadline) -> CommandFinish
+        {
+            if (!run->Step(deadline))
+                return {};
+
+            return [run](ChatHandler* to)
+            {
+                if (!to)
+                    return;
+
+                LoadReport const& report = run->Report();
+                auto line = [&](char const* name, LoadPhase const& phase, uint32 steps, char const* step)
+                {
+                    double sec = std::max<uint64>(phase.wallUs, 1) / 1e6;
+                    to->PSendSysMessage("|cff00ff00WeatherVibe:|r   %s: %u us (%.2f us/%s), %u packets -> %u recipients, %u bytes (%.0f recipients/s)",
+                        name, (uint32)phase.wallUs, double(phase.wallUs) / std::max<uint32>(steps, 1), step,
+                        (uint32)phase.sent.packets, (uint32)phase.sent.recipients, (uint32)phase.sent.bytes, phase.sent.recipients / sec);
+                };
+
+                to->PSendSysMessage("|cff00ff00WeatherVibe:|r loadtest: %u players over %u spots, %u ticks x %u ms",
+                    report.players, report.spots, report.ticks, g_AutoTickMs);
+                line("login storm", report.storm, report.players, "login");
+                line("ticks", report.ticking, report.ticks, "tick");
+                for (auto const& [zone, sent] : report.topZones)
+                    to->PSendSysMessage("|cff00ff00WeatherVibe:|r   zone %u: %u packets -> %u recipients, %u bytes",
+                        zone, (uint32)sent.packets, (uint32)sent.recipients, (uint32)sent.bytes);
+            };
+        });
+        return true;
+    }
+
+    // .wvibe selftest [ticks] [seed] -- property checks of the engine math + scheduler vs dense differential
+    static bool HandleWvibeSelfTest(ChatHandler* handler, Optional<uint32> ticks, Optional<uint32> seed)
+    {
+        if (RejectWhileReloading(handler) || RejectWhileSlicesFull(handler))
+            return false;
+
+        auto run = std::make_shared<SelfTestRun>(std::min(ticks.value_or(1000000), kMaxSelfTestTicks), seed.value_or(1));
+        RunInSlices(handler, [run](SliceClock::time_point deadline) -> CommandFinish
+        {
+            if (!run->Step(deadline))
+                return {};
+            return [run](ChatHandler* to)
+            {
+                if (to)
+                    run->Report(to);
+            };
+        });
+        return true;
+    }
+
+    // .wvibe pack build <file> -- compiles the loaded catalog into a binary pack under WeatherVibe.OutputDir
+    static bool HandleWvibePackBuild(ChatHandler* handler, std::string name)
+    {
+        std::string path, error;
+        if (!ResolveOutputPath(name, path, error) || !WriteProfilePack(path, error))
+        {
+            handler->PSendSysMessage("|cff00ff00WeatherVibe:|r pack build failed: %s", error.c_str());
+            return false;
+        }
+
+        handler->PSendSysMessage("|cff00ff00WeatherVibe:|r pack v%u written to %s (%u profiles, %u zone maps, %u parents). Set WeatherVibe.Pack.File to use it.",
+            kPackVersion, path.c_str(), (uint32)g_Profiles.size(), (uint32)g_ZoneProfile.size(), (uint32)g_ZoneParent.size());
+        return true;
+    }
+
+    static bool HandleWvibePackInfo(ChatHandler* handler)
+    {
+        handler->PSendSysMessage("|cff00ff00WeatherVibe:|r catalog source=%s file='%s' (%u profiles, %u zone maps, %u parents)",
+            g_PackActive ? "pack" : "config", g_PackFile.c_str(),
+            (uint32)g_Profiles.size(), (uint32)g_ZoneProfile.size(), (uint32)g_ZoneParent.size());
         return true;
     }
 
-    static bool HandleWvibeSet(ChatHandler* handler, uint32 zoneId, uint32 stateVal, float percentage)
+    static bool HandleWvibeSet(ChatHandler* handler, std::string zones, uint32 stateVal, float percentage)
     {
-        return HandleCommandPercent(handler, zoneId, stateVal, percentage);
+        return HandleCommandPercent(handler, zones, stateVal, percentage);
     }
-    static bool HandleWvibeSetRaw(ChatHandler* handler, uint32 zoneId, uint32 stateVal, float rawGrade)
+    static bool HandleWvibeSetRaw(ChatHandler* handler, std::string zones, uint32 stateVal, float rawGrade)
     {
-        return HandleCommandRaw(handler, zoneId, stateVal, rawGrade);
+        return HandleCommandRaw(handler, zones, stateVal, rawGrade);
     }
 
     // auto command table
@@ -1069,9 +6086,41 @@ public:
             { "on",       HandleAutoOn,       SEC_ADMINISTRATOR, Console::Yes },
             { "off",      HandleAutoOff,      SEC_ADMINISTRATOR, Console::Yes },
             { "status",   HandleAutoStatus,   SEC_ADMINISTRATOR, Console::Yes },
+            { "rates",    HandleAutoRates,    SEC_ADMINISTRATOR, Console::Yes },
+            { "tweenplan", HandleAutoTweenPlan, SEC_ADMINISTRATOR, Console::Yes },
             { "set",      HandleAutoSet,      SEC_ADMINISTRATOR, Console::Yes },
             { "clear",    HandleAutoClear,    SEC_ADMINISTRATOR, Console::Yes },
             { "sprinkle", HandleAutoSprinkle, SEC_ADMINISTRATOR, Console::Yes },
+            { "unsprinkle", HandleAutoUnsprinkle, SEC_ADMINISTRATOR, Console::Yes },
+        };
+
+        static ChatCommandTable timelineSet =
+        {
+            { "list",     HandleTimelineList,  SEC_ADMINISTRATOR, Console::Yes },
+            { "start",    HandleTimelineStart, SEC_ADMINISTRATOR, Console::Yes },
+            { "stop",     HandleTimelineStop,  SEC_ADMINISTRATOR, Console::Yes },
+            { "run",      HandleTimelineRun,   SEC_ADMINISTRATOR, Console::Yes },
+        };
+
+        static ChatCommandTable meSet =
+        {
+            { "",         HandleMeShow,    SEC_PLAYER, Console::No },
+            { "cap",      HandleMeCap,     SEC_PLAYER, Console::No },
+            { "block",    HandleMeBlock,   SEC_PLAYER, Console::No },
+            { "unblock",  HandleMeUnblock, SEC_PLAYER, Console::No },
+            { "reset",    HandleMeReset,   SEC_PLAYER, Console::No },
+        };
+
+        static ChatCommandTable benchSet =
+        {
+            { "parse",    HandleWvibeBenchParse, SEC_ADMINISTRATOR, Console::Yes },
+            { "areas",    HandleWvibeBenchAreas, SEC_ADMINISTRATOR, Console::Yes },
+        };
+
+        static ChatCommandTable packSet =
+        {
+            { "build",    HandleWvibePackBuild, SEC_ADMINISTRATOR, Console::Yes },
+            { "info",     HandleWvibePackInfo,  SEC_ADMINISTRATOR, Console::Yes },
         };
 
         static ChatCommandTable wvibeSet =
@@ -1080,7 +6129,14 @@ public:
             { "setRaw", HandleWvibeSetRaw, SEC_ADMINISTRATOR, Console::Yes },
             { "reload", HandleWvibeReload, SEC_ADMINISTRATOR, Console::Yes },
             { "show",   HandleWvibeShow,   SEC_ADMINISTRATOR, Console::Yes },
-            { "auto",   autoSet }
+            { "auto",   autoSet },
+            { "timeline", timelineSet },
+            { "me",     meSet },
+            { "bench",  benchSet },
+            { "pack",   packSet },
+            { "sim",    HandleWvibeSim, SEC_ADMINISTRATOR, Console::Yes },
+            { "loadtest", HandleWvibeLoadTest, SEC_ADMINISTRATOR, Console::Yes },
+            { "selftest", HandleWvibeSelfTest, SEC_ADMINISTRATOR, Console::Yes }
         };
         static ChatCommandTable root =
         {
@@ -1104,27 +6160,35 @@ public:
             return;
         
         ChatHandler(player->GetSession()).SendSysMessage("|cff00ff00WeatherVibe:|r enabled.");
-        uint32 controller = ResolveControllerZone(player->GetZoneId());
-        if (auto it = g_AutoZones.find(controller); it != g_AutoZones.end() && it->second.enabled)
-        {
-            SeedAutoFromLastApplied(controller, it->second);
-        }
-        
-        PushLastAppliedWeatherToClient(player->GetZoneId(), player);
+        PlayerArrived(WeatherRecipient{ player->GetGUID(), player }, player->GetZoneId(), player->GetAreaId());
     }
 
-    void OnPlayerUpdateZone(Player* player, uint32 newZone, uint32 /*newArea*/) override
+    void OnPlayerUpdateZone(Player* player, uint32 newZone, uint32 newArea) override
     {
         if (!g_EnableModule) 
             return;
         
-        uint32 controller = ResolveControllerZone(newZone);
-        if (auto it = g_AutoZones.find(controller); it != g_AutoZones.end() && it->second.enabled)
-        {
-            SeedAutoFromLastApplied(controller, it->second);
-        }
-        
-        PushLastAppliedWeatherToClient(newZone, player);
+        PlayerArrived(WeatherRecipient{ player->GetGUID(), player }, newZone, newArea);
+    }
+
+    void OnPlayerUpdateArea(Player* player, uint32 /*oldArea*/, uint32 newArea) override
+    {
+        if (!g_EnableModule)
+            return;
+
+        PlayerChangedArea(WeatherRecipient{ player->GetGUID(), player }, player->GetZoneId(), newArea);
+    }
+
+    void OnPlayerLogout(Player* player) override
+    {
+        PlayerLeft(player->GetGUID());
+    }
+
+    void OnPlayerDelete(ObjectGuid guid, uint32 /*accountId*/) override
+    {
+        // also when personal weather is off: the row must not outlive the character
+        g_PlayerPrefs.erase(guid.GetCounter());
+        SavePlayerPrefs(guid.GetCounter(), PlayerPrefs{});
     }
 };
 
@@ -1146,14 +6210,17 @@ public:
         }
 
         g_Debug = sConfigMgr->GetOption<uint32>("WeatherVibe.Debug", 0) != 0;
+        g_PersonalEnabled = sConfigMgr->GetOption<bool>("WeatherVibe.Personal.Enable", true);
+        if (g_PersonalEnabled)
+            LoadPlayerPrefs();
 
-        LoadDayPartConfig();
-        LoadStateRanges();
-        LoadProfiles();
-        LoadAutoConfig();
-        InitializeAutoZonesFromConfig();
+        ReloadResult r;
+        r.config = ConfigSnapshot::Take();
+        BuildReload(r, g_LastApplied, g_EngineNowMs);
+        InstallReload(r);
+        LogConfigSummary(r.parseUs);
 
-        g_LastApplied.clear();
+        g_LastApplied.Clear();
 
         LOG_INFO("server.loading", "[WeatherVibe] started (packet mode, per-state ranges, auto engine)");
     }
@@ -1161,6 +6228,7 @@ public:
     void OnUpdate(uint32 diff) override
     {
         if (!g_EnableModule) return;
+        DrainBackgroundCommands();
         static uint32 acc = 0;
         acc += diff;
         while (acc >= g_AutoTickMs)
@@ -1168,6 +6236,12 @@ public:
             ApplyAutoTick(g_AutoTickMs);
             acc -= g_AutoTickMs;
         }
+        StepSlicedCommands();
+    }
+
+    void OnShutdown() override
+    {
+        CancelCommands();
     }
 };
 